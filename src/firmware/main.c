@@ -6,93 +6,1540 @@
 -- REVISIONS   :
 --------------------------------------------------------------------------*/
 
-#include <stdio.h>
 #include <stdbool.h>
-#include <stdlib.h>
-#include <string.h>
-#include <math.h>
 #include <stdint.h>
 
-#include <libbase/uart.h>
-#include <libbase/console.h>
+#include <irq.h>
+
+#include <generated/soc.h>
+#include <generated/mem.h>
+#include <generated/csr.h>
+
+#ifndef CONFIG_FIXED_POINT
+#include <math.h>
+#endif
+
+#include "vctcxo_tamer.h"
+#include "profile.h"
+#include "telemetry.h"
+
+/*-----------------------------------------------------------------------*/
+/* Constants                                                             */
+/*-----------------------------------------------------------------------*/
+
+#define VCTCXO_DEFAULT_DAC_VALUE 0x77FA
+
+/* delay_ms() busy loop iterations per millisecond (without the cycle
+   counter), computed by the generator from the system clock. The CPU is a
+   bit-serial core (instructions take 32+ cycles) and the loop takes ~320
+   cycles/iter (measured against the cycle counter). */
+#ifndef CONFIG_DELAY_MS_LOOPS
+#define CONFIG_DELAY_MS_LOOPS \
+    ((CONFIG_CLOCK_FREQUENCY / 320000u) ? (CONFIG_CLOCK_FREQUENCY / 320000u) : 1u)
+#endif
+
+/* delay_ms() with the cycle counter: cycles per millisecond and longest
+   single wait (half of the 32-bit counter range). */
+#define DELAY_CYCLES_PER_MS (CONFIG_CLOCK_FREQUENCY / 1000u)
+#define DELAY_MS_MAX        ((1u << 31) / DELAY_CYCLES_PER_MS)
+
+/* FINE_TUNE proportional engine (1s/10s/100s/long windows). */
+#if !defined(CONFIG_FINE_TUNE_PI) && !defined(CONFIG_FINE_TUNE_PHASE) && \
+    !defined(CONFIG_FINE_TUNE_ADAPTIVE)
+#define FINE_TUNE_WINDOWS
+#endif
+
+/* FINE_TUNE engines based on the PI loop (frequency or phase lock). */
+#if defined(CONFIG_FINE_TUNE_PI) || defined(CONFIG_FINE_TUNE_PHASE)
+#define FINE_TUNE_PI_LOOP
+#endif
+
+/* FINE_TUNE PI loop gains, as powers of two: Kp = 2^-KP_SHIFT (frequency
+   term), Ki = 2^-KI_SHIFT (phase term). Defaults give a critically damped
+   loop with a ~4s time constant. */
+#ifndef CONFIG_PI_KP_SHIFT
+#define CONFIG_PI_KP_SHIFT 2
+#endif
+#ifndef CONFIG_PI_KI_SHIFT
+#define CONFIG_PI_KI_SHIFT 6
+#endif
+
+#if CONFIG_PI_KI_SHIFT < CONFIG_PI_KP_SHIFT
+#error "CONFIG_PI_KI_SHIFT must be greater or equal to CONFIG_PI_KP_SHIFT"
+#endif
+#if defined(CONFIG_FINE_TUNE_PI) && !defined(CSR_PPS_TIMESTAMP_BASE)
+#error "The FINE_TUNE PI loop requires the continuous-count mode (a measurement on every PPS)"
+#endif
+
+/* Phase accumulator limit (anti-windup). */
+#define PI_PHASE_MAX (1 << 20)
+
+/* COARSE_TUNE_SEARCH: maximum number of measurements and size of the first
+   step away from the default DAC value (in DAC counts). */
+#define COARSE_SEARCH_MAX_ITER 16
+#define COARSE_SEARCH_STEP     ((CONFIG_DAC_MAX + 1) / 8)
+#define COARSE_SEARCH_SETTLE   16
+
+/* Maximum trim DAC value in 1/2^DAC_FRAC_BITS DAC counts (DAC dither). */
+#define DAC_MAX_FRAC ((int32_t)CONFIG_DAC_MAX << DAC_FRAC_BITS)
+
+/* FINE_TUNE adaptive interval: maximum window length (4^N seconds), variance
+   filter (EMA, 2^-N) and significance thresholds (squared, in sigmas) to
+   step to a longer window (mean error within the noise) or back to a
+   shorter one (mean error well above the noise). */
+#ifndef CONFIG_ADAPTIVE_MAX_LEVEL
+#define CONFIG_ADAPTIVE_MAX_LEVEL 5
+#endif
+#if CONFIG_ADAPTIVE_MAX_LEVEL > 7
+#error "CONFIG_ADAPTIVE_MAX_LEVEL must be lower or equal to 7"
+#endif
+#define ADAPTIVE_ERROR_MAX (1 << 20)
+#define ADAPTIVE_VAR_SHIFT 4
+#define ADAPTIVE_UP_K2     9
+#define ADAPTIVE_DOWN_K2   36
+
+/* FINE_TUNE outlier filter: rejection threshold as a multiple of the MAD
+   (2^N, ~3 sigma for gaussian noise). */
+#define OUTLIER_MAD_SHIFT 2
+
+/* Temperature compensation: first node temperature and node spacing (2^N),
+   in 1/16 C units (defaults: -40C, 8C), and learning filter (EMA, 2^-N). */
+#ifndef CONFIG_TEMP_COMP_MIN
+#define CONFIG_TEMP_COMP_MIN   (-40 * 16)
+#endif
+#ifndef CONFIG_TEMP_COMP_SHIFT
+#define CONFIG_TEMP_COMP_SHIFT 7
+#endif
+#define TEMP_COMP_EMA_SHIFT    3
+
+/* Lock quality: statistics window (EMA, 2^N samples), error saturation
+   (|error| < 2^22 counts: no overflow of the Q8 statistics) and unlock
+   threshold (2^N times the lock threshold). */
+#ifndef CONFIG_LOCK_QUALITY_SHIFT
+#define CONFIG_LOCK_QUALITY_SHIFT 6
+#endif
+#define LOCK_QUALITY_ERROR_MAX    ((1 << 22) - 1)
+#define LOCK_QUALITY_UNLOCK_SHIFT 1
+
+/* PPS source voting: score filter (EMA, 2^N samples, also the number of
+   samples a source needs before it can be selected) and switch hysteresis
+   (score 2^N times and PPS_VOTE_FLOOR lower than the selected source, in
+   counts Q8: no switching between sources with equal jitter). */
+#define PPS_VOTE_SHIFT      4
+#define PPS_VOTE_HYST_SHIFT 1
+#define PPS_VOTE_FLOOR      (2 << 8)
+#define PPS_VOTE_CHANGE_MAX ((1 << 23) - 1)
+
+/* HOLDOVER: drift model window (2^N FINE_TUNE samples), drift filter
+   (EMA, 2^-N) and DAC update period (one PPS interval). Without
+   CONFIG_HOLDOVER, the trim DAC is held at its last value in HOLDOVER. */
+#define HOLDOVER_WINDOW_SHIFT 6
+#define HOLDOVER_EMA_SHIFT    3
+#define HOLDOVER_FRAC_BITS    16
+#define HOLDOVER_STEP_MS      1000
+
+/* 10 MHz reference: reference ticks per second (one measurement per tick,
+   the loops run per measurement) and PI gains lowered by 2^N, about the
+   rate, for the lower resolution of the 1/CONFIG_REF_RATE s errors. */
+#ifndef CONFIG_REF_RATE
+#define CONFIG_REF_RATE 1
+#endif
+#ifndef CONFIG_REF_SHIFT
+#define CONFIG_REF_SHIFT 0
+#endif
+#if (HOLDOVER_STEP_MS % CONFIG_REF_RATE) != 0
+#error "CONFIG_REF_RATE must divide 1000"
+#endif
+
+/*-----------------------------------------------------------------------*/
+/* Global Variables                                                      */
+/*-----------------------------------------------------------------------*/
+
+struct vctcxo_tamer_pkt_buf vctcxo_tamer_pkt;
+
+#ifdef VCTCXO_TAMER_IRQ_INTERRUPT
+/* Enable/PPS active change or long window completed since the main loop last
+   went to sleep (set by the ISR, sampled by the main loop once woken up). */
+static volatile bool vctcxo_tamer_event;
+#endif
+
+/*-----------------------------------------------------------------------*/
+/* Helpers                                                               */
+/*-----------------------------------------------------------------------*/
+
+#ifdef CSR_CYCLE_COUNTER_BASE
+/* Waits until the cycle counter reaches end (wrap-around safe).
+ * With CPU interrupts, the CPU sleeps (wfi) until the counter compare event.
+ * Interrupts are masked while checking the counter so that the event is not
+ * missed (wfi still wakes up on a pending interrupt when they are masked).
+ *
+ * @param end The cycle counter value to wait for.
+ */
+static void cycle_wait(uint32_t end)
+{
+#ifdef CYCLE_COUNTER_INTERRUPT
+    unsigned int ie = irq_getie();
+
+    cycle_counter_compare_write(end);
+    cycle_counter_ev_pending_write(cycle_counter_ev_pending_read());
+    cycle_counter_ev_enable_write(1);
+    irq_setmask(irq_getmask() | (1 << CYCLE_COUNTER_INTERRUPT));
+#endif
+
+    while ((int32_t)(cycle_counter_value_read() - end) < 0) {
+#ifdef CYCLE_COUNTER_INTERRUPT
+        irq_setie(0);
+        if ((int32_t)(cycle_counter_value_read() - end) < 0) {
+            __asm__ volatile ("wfi");
+        }
+        irq_setie(ie);
+#endif
+    }
+}
+#endif
+
+/* Simple local delay in milliseconds.
+ * With the cycle counter, the delay is exact (in sys clock cycles) and the
+ * CPU sleeps when interrupts are available. Otherwise, it is a busy loop
+ * whose timing depends on the CPU and compiler; we avoid using external
+ * busy_wait() to prevent toolchain confusion. */
+static void delay_ms(uint32_t ms)
+{
+#ifdef CSR_CYCLE_COUNTER_BASE
+    uint32_t end = cycle_counter_value_read();
+
+    while (ms > 0) {
+        uint32_t step = (ms > DELAY_MS_MAX) ? DELAY_MS_MAX : ms;
+
+        end += step * DELAY_CYCLES_PER_MS;
+        ms  -= step;
+        cycle_wait(end);
+    }
+#else
+    for (uint32_t m = 0; m < ms; m++) {
+        for (volatile uint32_t i = 0; i < CONFIG_DELAY_MS_LOOPS; i++) {
+            __asm__ volatile ("nop");
+        }
+    }
+#endif
+}
+
+/* Computes the slope (DAC counts per error count) of the line going through
+ * two calibration points.
+ *
+ * @param dy The DAC count difference between the two points.
+ * @param dx The error difference between the two points (non-zero).
+ */
+static slope_t line_slope(int32_t dy, int32_t dx)
+{
+#ifdef CONFIG_FIXED_POINT
+    /* Work on magnitudes so the Q16.16 quotient fits a 32-bit unsigned
+       division (dy is at most 16-bit wide). */
+    uint32_t num = ((uint32_t)(dy < 0 ? -dy : dy)) << SLOPE_FRAC_BITS;
+    uint32_t den = (uint32_t)(dx < 0 ? -dx : dx);
+    uint32_t q   = (num + (den >> 1)) / den;
+
+    if (q > INT32_MAX) {
+        q = INT32_MAX;
+    }
+
+    return ((dy < 0) != (dx < 0)) ? -(int32_t)q : (int32_t)q;
+#else
+    return (float)dy / (float)dx;
+#endif
+}
+
+/* Multiplies an error by the calibration slope and rounds the result to the
+ * nearest 1/2^frac DAC count (halfway cases away from zero, as lroundf()).
+ *
+ * @param error The PPS error value.
+ * @param slope The calibration slope.
+ * @param frac  The number of fractional bits of the result.
+ */
+static int32_t slope_apply_frac(int32_t error, slope_t slope, int frac)
+{
+#ifdef CONFIG_FIXED_POINT
+    const int64_t half = (int64_t)1 << (SLOPE_FRAC_BITS - frac - 1);
+    int64_t product    = (int64_t)error * slope;
+    int64_t value;
+
+    if (product < 0) {
+        value = -((-product + half) >> (SLOPE_FRAC_BITS - frac));
+    } else {
+        value = (product + half) >> (SLOPE_FRAC_BITS - frac);
+    }
+
+    /* Saturate to the 32-bit range. */
+    if (value > INT32_MAX) {
+        value = INT32_MAX;
+    } else if (value < INT32_MIN) {
+        value = INT32_MIN;
+    }
+
+    return (int32_t)value;
+#else
+    return (int32_t)lroundf((float)error * slope * (float)(1 << frac));
+#endif
+}
+
+/* Multiplies an error by the calibration slope and rounds the result to the
+ * nearest DAC count.
+ *
+ * @param error The PPS error value.
+ * @param slope The calibration slope.
+ */
+static int32_t slope_apply(int32_t error, slope_t slope)
+{
+    return slope_apply_frac(error, slope, 0);
+}
+
+#ifdef CSR_CALIBRATION_BASE
+/* Converts a calibration slope from/to the Q16.16 format used on the
+ * calibration CSRs. */
+static slope_t slope_from_q16(int32_t q16)
+{
+#ifdef CONFIG_FIXED_POINT
+    return q16;
+#else
+    return (float)q16 / 65536.0f;
+#endif
+}
+
+static int32_t slope_to_q16(slope_t slope)
+{
+#ifdef CONFIG_FIXED_POINT
+    return slope;
+#else
+    return (int32_t)lroundf(slope * 65536.0f);
+#endif
+}
+#endif
+
+/* Returns the trim DAC value in 1/2^DAC_FRAC_BITS DAC counts. */
+static int32_t read_trim_dac(void)
+{
+    return ((int32_t)vctcxo_trim_dac_value << DAC_FRAC_BITS) | vctcxo_trim_dac_frac;
+}
+
+/* Writes the trim DAC value clamped to the DAC limits.
+ *
+ * @param value The new trim DAC value in 1/2^DAC_FRAC_BITS DAC counts
+ *              (signed, may be out of range).
+ */
+static void write_trim_dac(int32_t value)
+{
+    /* The DAC range starts at 0: one unsigned compare for both limits. */
+    if ((uint32_t)value > DAC_MAX_FRAC) {
+        value = (value < 0) ? 0 : DAC_MAX_FRAC;
+    }
+
+    /* Write value to VCTCXO Tamer (also updates vctcxo_trim_dac_value). */
+    vctcxo_trim_dac_write_frac((uint32_t)value);
+}
+
+#ifdef FINE_TUNE_WINDOWS
+/* Adjusts the trim DAC value based on error and slope. Longer windows use a
+ * slope pre-scaled by the window length (see window_slopes_reset()), so no
+ * division is needed on the update path.
+ *
+ * @param error The PPS error value.
+ * @param slope The calibration slope.
+ */
+static void adjust_trim_dac(int32_t error, slope_t slope)
+{
+    write_trim_dac(read_trim_dac() - slope_apply_frac(error, slope, DAC_FRAC_BITS));
+}
+
+/* Adjusts the trim DAC value based on error, slope and a window length only
+ * known at run time (long window).
+ *
+ * @param error The PPS error value.
+ * @param slope The calibration slope.
+ * @param scale The window length (seconds).
+ */
+static void adjust_trim_dac_div(int32_t error, slope_t slope, int32_t scale)
+{
+    write_trim_dac(read_trim_dac() - slope_apply_frac(error, slope, DAC_FRAC_BITS) / scale);
+}
+
+/* Pre-scales the calibration slope for the 10s/100s windows.
+ *
+ * @param ws    The pre-scaled slopes.
+ * @param slope The calibration slope.
+ */
+static void window_slopes_reset(window_slopes_t *ws, slope_t slope)
+{
+#ifdef CONFIG_FIXED_POINT
+    ws->slope_10s  = slope / 10;
+    ws->slope_100s = slope / 100;
+#else
+    ws->slope_10s  = slope * 0.1f;
+    ws->slope_100s = slope * 0.01f;
+#endif
+}
+#else
+/* Adjusts the trim DAC value based on error and slope, scaled by 2^-shift
+ * (rounded toward zero, as a division by 2^shift).
+ *
+ * @param error The PPS error value.
+ * @param slope The calibration slope.
+ * @param shift The scaling factor, as a power of two.
+ */
+static void adjust_trim_dac_shift(int32_t error, slope_t slope, int shift)
+{
+    int32_t delta = slope_apply_frac(error, slope, DAC_FRAC_BITS);
+
+    delta = (delta + ((delta >> 31) & ((1 << shift) - 1))) >> shift;
+    write_trim_dac(read_trim_dac() - delta);
+}
+#endif
+
+/* Publishes the calibration slope so the host can save it for a warm start. */
+static void calibration_publish(const line_t *line)
+{
+#ifdef CSR_CALIBRATION_BASE
+    calibration_slope_write((uint32_t)slope_to_q16(line->slope));
+#else
+    (void)line;
+#endif
+}
+
+#ifdef CSR_CONFIG_UPDATE_BASE
+/* Rescales the calibration slope (DAC counts per error count) to a new 1s
+ * target (e.g. RF clock change): the error counts scale with the target, the
+ * DAC counts do not.
+ *
+ * @param line The calibration line to update.
+ * @param from The 1s target the slope was calibrated at (non-zero).
+ * @param to   The new 1s target (non-zero, below 2^31).
+ */
+static void calibration_rescale(line_t *line, uint32_t from, uint32_t to)
+{
+#ifdef CONFIG_FIXED_POINT
+    /* from/to in Q16.16 by long division of the remainder (32-bit operations
+       only), applied to the slope magnitude. */
+    uint32_t ratio = from / to;
+    uint32_t rem   = from % to;
+    uint64_t mag   = (uint64_t)(line->slope < 0 ? -(int64_t)line->slope : line->slope);
+
+    for (int i = 0; i < SLOPE_FRAC_BITS; i++) {
+        rem   <<= 1;
+        ratio <<= 1;
+        if (rem >= to) {
+            rem   -= to;
+            ratio |= 1;
+        }
+    }
+    mag = (mag * ratio + (1 << (SLOPE_FRAC_BITS - 1))) >> SLOPE_FRAC_BITS;
+    if (mag > INT32_MAX) {
+        mag = INT32_MAX;
+    }
+    line->slope = (line->slope < 0) ? -(int32_t)mag : (int32_t)mag;
+#else
+    line->slope *= (float)from / (float)to;
+#endif
+    calibration_publish(line);
+}
+#endif
+
+/* Loads the warm start calibration (slope and trim DAC value) when requested
+ * by the host.
+ *
+ * @param line    The calibration line to update.
+ * @param dac_max The maximum trim DAC value.
+ * @return true when the coarse tune can be skipped.
+ */
+static bool calibration_warm_start(line_t *line, uint16_t dac_max)
+{
+#ifdef CSR_CALIBRATION_BASE
+    int32_t  slope = (int32_t)calibration_warm_slope_read();
+    uint32_t dac   = calibration_warm_dac_read();
+
+    if (!calibration_warm_start_read() || (slope == 0)) {
+        return false;
+    }
+
+    if (dac > dac_max) {
+        dac = dac_max;
+    }
+
+    line->slope       = slope_from_q16(slope);
+    line->y_intercept = (uint16_t)dac;
+    vctcxo_trim_dac_write((uint16_t)dac);
+    calibration_publish(line);
+
+    return true;
+#else
+    (void)line;
+    (void)dac_max;
+    return false;
+#endif
+}
+
+/* Pushes a per-PPS sample to the on-chip error history.
+ *
+ * @param pkt   The PPS measurement.
+ * @param state The tuning state the measurement is processed in.
+ */
+static void history_push(const struct vctcxo_tamer_pkt_buf *pkt, state_t state)
+{
+#ifdef CSR_HISTORY_BASE
+    uint32_t flags = 0;
+
+    flags |= pkt->pps_1s_error_flag   ? VT_STAT_ERR_1S   : 0;
+    flags |= pkt->pps_10s_error_flag  ? VT_STAT_ERR_10S  : 0;
+    flags |= pkt->pps_100s_error_flag ? VT_STAT_ERR_100S : 0;
+    flags |= pkt->pps_long_error_flag ? VT_STAT_ERR_LONG : 0;
+
+    history_data0_write((uint32_t)pkt->pps_1s_error);
+    history_data1_write((uint32_t)vctcxo_trim_dac_value |
+                        (((uint32_t)state & 0xF) << 16) |
+                        ((flags & 0xF) << 20));
+    history_push_write(1);
+#else
+    (void)pkt;
+    (void)state;
+#endif
+}
+
+#ifdef CONFIG_OUTLIER_WINDOW
+#if (CONFIG_OUTLIER_WINDOW > OUTLIER_WINDOW_MAX) || ((CONFIG_OUTLIER_WINDOW & 1) == 0)
+#error "CONFIG_OUTLIER_WINDOW must be odd and <= OUTLIER_WINDOW_MAX"
+#endif
+
+/* Returns the median of n values (n odd, sorts the values in place). */
+static int32_t median(int32_t *v, uint8_t n)
+{
+    /* Insertion sort: n is small. */
+    for (uint8_t i = 1; i < n; i++) {
+        int32_t x = v[i];
+        int8_t  j = i - 1;
+        while ((j >= 0) && (v[j] > x)) {
+            v[j + 1] = v[j];
+            j--;
+        }
+        v[j + 1] = x;
+    }
+    return v[n / 2];
+}
+
+/* Resets the outlier filter window (kept: rejected sample counter). */
+static void outlier_filter_reset(outlier_filter_t *f)
+{
+    f->count = 0;
+    f->pos   = 0;
+}
+
+/* Checks a 1s error sample against the median/MAD of the last samples.
+ *
+ * Rejected samples are still added to the window so that a genuine step in
+ * the error is accepted once it makes up half of the window. Without the
+ * continuous-count mode, the Tamer only reports out of tolerance samples:
+ * the window then only holds those, and its median/MAD are biased away from
+ * zero (larger threshold, fewer rejections).
+ *
+ * @param f     The outlier filter state.
+ * @param error The 1s error sample.
+ *
+ * @return true when the sample is an outlier and must be discarded.
+ */
+static bool outlier_filter_reject(outlier_filter_t *f, int32_t error)
+{
+    int32_t  v[CONFIG_OUTLIER_WINDOW];
+    int32_t  med, mad, threshold;
+    uint32_t dev;
+    bool     reject;
+
+    f->sample[f->pos] = error;
+    f->pos = (f->pos + 1 < CONFIG_OUTLIER_WINDOW) ? (f->pos + 1) : 0;
+    if (f->count < CONFIG_OUTLIER_WINDOW) {
+        f->count++;
+        return false;
+    }
+
+    /* Median and median absolute deviation of the window. */
+    for (uint8_t i = 0; i < CONFIG_OUTLIER_WINDOW; i++) {
+        v[i] = f->sample[i];
+    }
+    med = median(v, CONFIG_OUTLIER_WINDOW);
+    for (uint8_t i = 0; i < CONFIG_OUTLIER_WINDOW; i++) {
+        v[i] = (f->sample[i] > med) ? (f->sample[i] - med) : (med - f->sample[i]);
+    }
+    mad = median(v, CONFIG_OUTLIER_WINDOW);
+
+    threshold = (mad < (INT32_MAX >> OUTLIER_MAD_SHIFT)) ? (mad << OUTLIER_MAD_SHIFT) : INT32_MAX;
+    if (threshold < CONFIG_OUTLIER_FLOOR) {
+        threshold = CONFIG_OUTLIER_FLOOR;
+    }
+    dev    = (error > med) ? (uint32_t)(error - med) : (uint32_t)(med - error);
+    reject = (dev > (uint32_t)threshold);
+
+    if (reject) {
+        f->rejected++;
+#ifdef CSR_OUTLIER_FILTER_BASE
+        outlier_filter_rejected_write(f->rejected);
+#endif
+    }
+    return reject;
+}
+#endif
+
+/* Returns true in 10 MHz reference mode (reference ticks measured instead
+   of PPS), as selected on enable. */
+static inline bool ref_mode(void)
+{
+    return vctcxo_tamer_tune_mode == VCTCXO_TAMER_10_MHZ;
+}
+
+#ifdef CONFIG_HOLDOVER
+/* Returns the measurement interval in ms (PPS or reference tick period). */
+static uint32_t sample_interval_ms(void)
+{
+    return ref_mode() ? (HOLDOVER_STEP_MS / CONFIG_REF_RATE) : HOLDOVER_STEP_MS;
+}
+#endif
+
+#ifdef CSR_LOCK_QUALITY_BASE
+#ifndef CSR_PPS_TIMESTAMP_BASE
+#error "Lock quality requires the continuous-count mode (a measurement on every PPS)"
+#endif
+
+/* Returns the integer square root of a 64-bit value (shifts and adds only,
+ * no multiplier on the CPU). */
+static uint32_t isqrt64(uint64_t x)
+{
+    uint64_t root = 0;
+    uint64_t bit  = (uint64_t)1 << 62;
+
+    while (bit > x) {
+        bit >>= 2;
+    }
+    while (bit != 0) {
+        if (x >= root + bit) {
+            x    -= root + bit;
+            root  = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)root;
+}
+
+/* Adds an error sample to the statistics of an interval.
+ *
+ * @param s     The interval statistics.
+ * @param error The interval error sample (counts).
+ */
+static void lock_stats_update(lock_stats_t *s, int32_t error)
+{
+    uint32_t magnitude;
+    int32_t  x;
+    int64_t  x2;
+
+    if (error > LOCK_QUALITY_ERROR_MAX) {
+        error = LOCK_QUALITY_ERROR_MAX;
+    } else if (error < -LOCK_QUALITY_ERROR_MAX) {
+        error = -LOCK_QUALITY_ERROR_MAX;
+    }
+    magnitude = (error < 0) ? (uint32_t)-error : (uint32_t)error;
+    x         = error * 256;
+    x2        = (int64_t)((uint64_t)magnitude * magnitude) * 256;
+
+    /* First sample: start from it (no bias towards 0). */
+    if (s->msq < 0) {
+        s->mean  = x;
+        s->msq   = x2;
+        s->peak  = (int32_t)(magnitude * 256);
+        return;
+    }
+
+    s->mean += (x - s->mean) >> CONFIG_LOCK_QUALITY_SHIFT;
+    s->msq  += (x2 - s->msq) >> CONFIG_LOCK_QUALITY_SHIFT;
+    s->peak -= s->peak >> CONFIG_LOCK_QUALITY_SHIFT;
+    if ((int32_t)(magnitude * 256) > s->peak) {
+        s->peak = (int32_t)(magnitude * 256);
+    }
+}
+
+/* Returns the RMS error of an interval (counts, Q8). */
+static uint32_t lock_stats_rms(const lock_stats_t *s)
+{
+    return (s->msq < 0) ? 0 : isqrt64((uint64_t)s->msq << 8);
+}
+
+/* Publishes the lock quality to the status outputs. */
+static void lock_quality_publish(const lock_quality_t *lq)
+{
+    lock_quality_mean_1s_write((uint32_t)lq->interval[0].mean);
+    lock_quality_rms_1s_write(lock_stats_rms(&lq->interval[0]));
+    lock_quality_max_1s_write((uint32_t)lq->interval[0].peak);
+    lock_quality_mean_10s_write((uint32_t)lq->interval[1].mean);
+    lock_quality_rms_10s_write(lock_stats_rms(&lq->interval[1]));
+    lock_quality_max_10s_write((uint32_t)lq->interval[1].peak);
+    lock_quality_mean_100s_write((uint32_t)lq->interval[2].mean);
+    lock_quality_rms_100s_write(lock_stats_rms(&lq->interval[2]));
+    lock_quality_max_100s_write((uint32_t)lq->interval[2].peak);
+    lock_quality_locked_write(lq->locked);
+    lock_quality_lock_time_write(lq->lock_time);
+}
+
+/* Resets the lock quality (unlocked, no statistics).
+ *
+ * @param lq The lock quality state.
+ */
+static void lock_quality_reset(lock_quality_t *lq)
+{
+    for (uint8_t i = 0; i < 3; i++) {
+        lq->interval[i].msq  = -1;
+        lq->interval[i].mean = 0;
+        lq->interval[i].peak = 0;
+    }
+    lq->count     = 0;
+    lq->locked    = false;
+    lq->ticks     = 0;
+    lq->lock_time = 0;
+    lock_quality_publish(lq);
+}
+
+/* Updates the lock quality with a FINE_TUNE measurement: statistics of the
+ * intervals completed on this PPS, then lock decision on the 1s RMS error
+ * (lock within the lock threshold once the window is filled, unlock over
+ * 2^LOCK_QUALITY_UNLOCK_SHIFT times the threshold).
+ *
+ * @param lq  The lock quality state.
+ * @param pkt The PPS measurement.
+ */
+static void lock_quality_update(lock_quality_t *lq, const struct vctcxo_tamer_pkt_buf *pkt)
+{
+    uint32_t tol;
+    uint32_t rms;
+
+    if (pkt->pps_windows & VT_STAT_ERR_10S) {
+        lock_stats_update(&lq->interval[1], pkt->pps_10s_error);
+    }
+    if (pkt->pps_windows & VT_STAT_ERR_100S) {
+        lock_stats_update(&lq->interval[2], pkt->pps_100s_error);
+    }
+    if (!(pkt->pps_windows & VT_STAT_ERR_1S)) {
+        return;
+    }
+    lock_stats_update(&lq->interval[0], pkt->pps_1s_error);
+    if (lq->count < (1 << CONFIG_LOCK_QUALITY_SHIFT)) {
+        lq->count++;
+    }
+
+    /* Lock threshold (Q8): host provided, defaults to the 1s tolerance. */
+    tol = lock_quality_tol_read();
+    if (tol == 0) {
+        tol = pps_timestamp_tol_1s_read() << 8;
+    }
+
+    rms = lock_stats_rms(&lq->interval[0]);
+    if (lq->locked) {
+        lq->locked = (rms <= (tol << LOCK_QUALITY_UNLOCK_SHIFT));
+        /* Lock time in seconds (CONFIG_REF_RATE samples per second with the
+           10 MHz reference). */
+        if (++lq->ticks >= (ref_mode() ? CONFIG_REF_RATE : 1)) {
+            lq->ticks = 0;
+            lq->lock_time++;
+        }
+    } else if ((lq->count >= (1 << CONFIG_LOCK_QUALITY_SHIFT)) && (rms <= tol)) {
+        lq->locked    = true;
+        lq->ticks     = 0;
+        lq->lock_time = 0;
+    }
+    if (!lq->locked) {
+        lq->lock_time = 0;
+    }
+
+    lock_quality_publish(lq);
+}
+#endif
+
+#ifdef CONFIG_TEMP_COMP
+/* Reads the host provided temperature (1/16 C), returns false if not valid. */
+static bool temp_comp_read(int16_t *temp)
+{
+    if ((temp_comp_valid_read() & 0x1) == 0) {
+        return false;
+    }
+    *temp = (int16_t)temp_comp_temp_read();
+    return true;
+}
+
+/* Returns the table node index nearest to a temperature. */
+static uint8_t temp_comp_nearest(int16_t temp)
+{
+    int32_t pos = (int32_t)temp - CONFIG_TEMP_COMP_MIN + (1 << (CONFIG_TEMP_COMP_SHIFT - 1));
+
+    if (pos < 0) {
+        return 0;
+    }
+    pos >>= CONFIG_TEMP_COMP_SHIFT;
+    return (pos >= TEMP_COMP_NODES) ? (TEMP_COMP_NODES - 1) : (uint8_t)pos;
+}
+
+/* Looks up the (interpolated) table DAC value at a temperature.
+ *
+ * @param tc    The temperature compensation table.
+ * @param temp  The temperature (1/16 C).
+ * @param value The table value (DAC counts, Q4).
+ *
+ * @return false when the nodes around the temperature are not learned yet.
+ */
+static bool temp_comp_lookup(const temp_comp_t *tc, int16_t temp, int32_t *value)
+{
+    const int32_t max = (int32_t)(TEMP_COMP_NODES - 1) << CONFIG_TEMP_COMP_SHIFT;
+    int32_t pos = (int32_t)temp - CONFIG_TEMP_COMP_MIN;
+    int32_t frac;
+    uint8_t i;
+
+    /* Clamp to the table range. */
+    if (pos < 0) {
+        pos = 0;
+    } else if (pos > max) {
+        pos = max;
+    }
+    i    = pos >> CONFIG_TEMP_COMP_SHIFT;
+    frac = pos & ((1 << CONFIG_TEMP_COMP_SHIFT) - 1);
+
+    if ((tc->valid & (1 << i)) == 0) {
+        return false;
+    }
+    *value = (int32_t)tc->node[i] << 4;
+    if (frac != 0) {
+        if ((tc->valid & (1 << (i + 1))) == 0) {
+            return false;
+        }
+        *value += (((int32_t)tc->node[i + 1] - tc->node[i]) * frac * 16) >> CONFIG_TEMP_COMP_SHIFT;
+    }
+    return true;
+}
+
+/* Resets the temperature compensation table. */
+static void temp_comp_reset(temp_comp_t *tc)
+{
+    tc->valid     = 0;
+    tc->ref_valid = false;
+}
+
+/* Learns the trim DAC value at the current temperature (FINE_TUNE, when the
+ * DAC is steered by the PPS error) and rebases the feed-forward reference so
+ * that learning itself does not move the DAC.
+ *
+ * @param tc  The temperature compensation table.
+ * @param dac The trim DAC value.
+ */
+static void temp_comp_learn(temp_comp_t *tc, uint16_t dac)
+{
+    int16_t temp;
+    uint8_t i;
+    int32_t delta;
+
+    if (!temp_comp_read(&temp)) {
+        tc->ref_valid = false;
+        return;
+    }
+
+    i = temp_comp_nearest(temp);
+    if (tc->valid & (1 << i)) {
+        /* EMA (rounded). */
+        delta = (int32_t)dac - tc->node[i];
+        tc->node[i] += (delta + (1 << (TEMP_COMP_EMA_SHIFT - 1))) >> TEMP_COMP_EMA_SHIFT;
+    } else {
+        tc->node[i] = dac;
+        tc->valid  |= 1 << i;
+    }
+
+    tc->ref_valid = temp_comp_lookup(tc, temp, &tc->ref);
+}
+
+/* Returns the trim DAC feed-forward correction (DAC counts) for the
+ * temperature change since the last call. */
+static int32_t temp_comp_feedforward(temp_comp_t *tc)
+{
+    int16_t temp;
+    int32_t value, delta;
+
+    if (!temp_comp_read(&temp) || !temp_comp_lookup(tc, temp, &value)) {
+        tc->ref_valid = false;
+        return 0;
+    }
+    if (!tc->ref_valid) {
+        tc->ref       = value;
+        tc->ref_valid = true;
+        return 0;
+    }
+
+    /* Whole DAC counts, the fractional part is kept in the reference. */
+    delta    = (value - tc->ref) / 16;
+    tc->ref += delta * 16;
+    return delta;
+}
+
+/* Offsets the trim DAC value (clamped to the DAC limits). */
+static void offset_trim_dac(int32_t delta)
+{
+    write_trim_dac(read_trim_dac() + delta * (1 << DAC_FRAC_BITS));
+}
+#endif
+
+/* Returns the PPS Detector active status (10 MHz reference: reference
+   active status, always active when not available). */
+static bool pps_is_active(void)
+{
+#ifdef CSR_PPS_STATUS_BASE
+    return pps_status_active_read() & 0x1;
+#else
+    return true;
+#endif
+}
+
+#ifdef CSR_PPS_SELECT_BASE
+#ifndef CSR_PPS_TIMESTAMP_BASE
+#error "PPS source voting requires the continuous-count mode (PPS timestamps)"
+#endif
+#if CONFIG_PPS_INPUTS > PPS_SOURCES_MAX
+#error "CONFIG_PPS_INPUTS must be <= PPS_SOURCES_MAX"
+#endif
+
+/* Resets the per-source statistics (the selected source is kept). */
+static void pps_vote_reset(pps_vote_t *v)
+{
+    for (uint8_t i = 0; i < CONFIG_PPS_INPUTS; i++) {
+        v->source[i].valid   = false;
+        v->source[i].fresh   = false;
+        v->source[i].samples = 0;
+        v->source[i].score   = 0;
+    }
+}
+
+/* Returns true when a source can be selected (active, score settled). */
+static bool pps_vote_qualified(const pps_vote_t *v, uint8_t i)
+{
+    return v->source[i].valid && (v->source[i].samples > (1 << PPS_VOTE_SHIFT));
+}
+
+/* Selects a PPS source.
+ *
+ * Hitless: the continuous-count windows are moved to the new source (same
+ * PPS epoch on both sources), otherwise they restart on its next PPS.
+ *
+ * @param v       The voting state.
+ * @param sel     The new source.
+ * @param hitless True to keep the windows.
+ * @param offset  The new source minus the selected source timestamp.
+ */
+static void pps_vote_switch(pps_vote_t *v, uint8_t sel, bool hitless, int32_t offset)
+{
+    pps_select_source_write(sel);
+    if (hitless) {
+        pps_timestamp_rebase(offset);
+    } else {
+        pps_timestamp_reset();
+    }
+#ifdef CONFIG_FINE_TUNE_PHASE
+    /* Phase measured from zero on the new source (no pull from the offset
+       between the sources). */
+    pps_timestamp_realign();
+#endif
+    v->sel = sel;
+    v->switches++;
+}
+
+/* Updates the per-source 1s errors and scores from the PPS Select
+ * timestamps (on each PPS of the selected source), then switches to a
+ * better source when one is qualified and its score is 2^PPS_VOTE_HYST_SHIFT
+ * times lower.
+ *
+ * @param v The voting state.
+ */
+static void pps_vote_update(pps_vote_t *v)
+{
+    uint32_t active = pps_select_active_read();
+    uint32_t target = pps_timestamp_target_1s_read();
+    uint8_t  best   = v->sel;
+
+    for (uint8_t i = 0; i < CONFIG_PPS_INPUTS; i++) {
+        pps_source_t *s = &v->source[i];
+        uint32_t ts, change;
+        uint8_t  count;
+        int32_t  error;
+
+        s->fresh = false;
+        if (!(active & (1 << i))) {
+            s->valid   = false;
+            s->samples = 0;
+            continue;
+        }
+
+        /* Coherent count/timestamp (a PPS edge may land between the reads). */
+        pps_select_rd_source_write(i);
+        do {
+            count = (uint8_t)pps_select_rd_count_read();
+            ts    = pps_select_rd_timestamp_read();
+        } while (count != (uint8_t)pps_select_rd_count_read());
+
+        /* Source edge not captured yet (later than the selected source):
+           used on the next vote. */
+        if (s->valid && (count == s->count)) {
+            continue;
+        }
+
+        /* First edge or missed edges: restart from this one. */
+        if (!s->valid || ((uint8_t)(count - s->count) != 1)) {
+            s->valid   = true;
+            s->samples = 0;
+            s->last    = ts;
+            s->count   = count;
+            continue;
+        }
+
+        error    = (int32_t)(ts - s->last - target);
+        s->last  = ts;
+        s->count = count;
+        s->fresh = true;
+
+        if (s->samples > 0) {
+            change = (error > s->error) ? (uint32_t)(error - s->error) : (uint32_t)(s->error - error);
+            if (change > PPS_VOTE_CHANGE_MAX) {
+                change = PPS_VOTE_CHANGE_MAX;
+            }
+            if (s->samples == 1) {
+                s->score = change << 8;
+            } else {
+                s->score += ((int32_t)(change << 8) - (int32_t)s->score) >> PPS_VOTE_SHIFT;
+            }
+        }
+        if (s->samples < UINT8_MAX) {
+            s->samples++;
+        }
+        s->error = error;
+    }
+
+    /* Best qualified source. */
+    for (uint8_t i = 0; i < CONFIG_PPS_INPUTS; i++) {
+        if (pps_vote_qualified(v, i) &&
+            (!pps_vote_qualified(v, best) || (v->source[i].score < v->source[best].score))) {
+            best = i;
+        }
+    }
+    if ((best == v->sel) ||
+        (pps_vote_qualified(v, v->sel) &&
+         (((v->source[v->sel].score >> PPS_VOTE_HYST_SHIFT) <= v->source[best].score) ||
+          (v->source[v->sel].score <= v->source[best].score + PPS_VOTE_FLOOR)))) {
+        return;
+    }
+
+    /* Hitless when both timestamps are from this PPS epoch. */
+    {
+        const pps_source_t *cur = &v->source[v->sel];
+        const pps_source_t *alt = &v->source[best];
+        int32_t offset  = (int32_t)(alt->last - cur->last);
+        bool    hitless = cur->fresh && alt->fresh &&
+                          ((offset < 0 ? -(uint32_t)offset : (uint32_t)offset) < (target >> 1));
+        pps_vote_switch(v, best, hitless, offset);
+    }
+}
+
+/* Switches to another active source when the selected one is lost (best
+ * qualified one, else the first active one), the windows restart on its
+ * next PPS. Returns false when no source is active.
+ *
+ * @param v The voting state.
+ */
+static bool pps_vote_failover(pps_vote_t *v)
+{
+    uint32_t active = pps_select_active_read();
+    int8_t   best   = -1;
+
+    for (uint8_t i = 0; i < CONFIG_PPS_INPUTS; i++) {
+        if ((i == v->sel) || !(active & (1 << i))) {
+            continue;
+        }
+        if ((best < 0) ||
+            (pps_vote_qualified(v, i) &&
+             (!pps_vote_qualified(v, best) || (v->source[i].score < v->source[best].score)))) {
+            best = i;
+        }
+    }
+    if (best < 0) {
+        return false;
+    }
+    v->source[v->sel].valid   = false;
+    v->source[v->sel].samples = 0;
+    pps_vote_switch(v, (uint8_t)best, false, 0);
+    return true;
+}
+#endif
+
+#ifdef CONFIG_HOLDOVER
+/* Resets the HOLDOVER drift model. */
+static void holdover_reset(holdover_t *ho)
+{
+    ho->sum         = 0;
+    ho->count       = 0;
+    ho->avg_valid   = false;
+    ho->drift_valid = false;
+    ho->avg         = 0;
+    ho->drift       = 0;
+    ho->dac         = 0;
+}
+
+/* Restarts the HOLDOVER learning window, keeping the drift estimate (used
+ * when re-acquiring after a holdover). */
+static void holdover_resume(holdover_t *ho)
+{
+    ho->sum       = 0;
+    ho->count     = 0;
+    ho->avg_valid = false;
+}
+
+/* Learns the DAC drift from a FINE_TUNE sample.
+ *
+ * @param ho  The holdover state.
+ * @param dac The trim DAC value after the FINE_TUNE update (in
+ *            1/2^DAC_FRAC_BITS DAC counts).
+ */
+static void holdover_learn(holdover_t *ho, int32_t dac)
+{
+    int64_t avg;
+    int32_t drift;
+
+    ho->sum += dac;
+    if (++ho->count < (1 << HOLDOVER_WINDOW_SHIFT)) {
+        return;
+    }
+
+    /* End of window: average and drift vs previous window. */
+    avg = ((int64_t)ho->sum << (HOLDOVER_FRAC_BITS - DAC_FRAC_BITS)) >> HOLDOVER_WINDOW_SHIFT;
+    if (ho->avg_valid) {
+        drift = (int32_t)((avg - ho->avg) >> HOLDOVER_WINDOW_SHIFT);
+        if (ho->drift_valid) {
+            ho->drift += (drift - ho->drift) >> HOLDOVER_EMA_SHIFT;
+        } else {
+            ho->drift       = drift;
+            ho->drift_valid = true;
+        }
+    }
+    ho->avg       = avg;
+    ho->avg_valid = true;
+    ho->sum       = 0;
+    ho->count     = 0;
+}
+
+/* Enters HOLDOVER: starts from the last window average (the last DAC value
+ * may be in the middle of a correction). */
+static void holdover_enter(holdover_t *ho)
+{
+    if (ho->avg_valid) {
+        ho->dac = ho->avg;
+    } else {
+        ho->dac = (int64_t)read_trim_dac() << (HOLDOVER_FRAC_BITS - DAC_FRAC_BITS);
+    }
+}
+
+/* Applies the drift model for one HOLDOVER step.
+ *
+ * @param ho      The holdover state.
+ * @param dac_max The maximum trim DAC value.
+ */
+static void holdover_step(holdover_t *ho, uint16_t dac_max)
+{
+    const int64_t max = (int64_t)dac_max << HOLDOVER_FRAC_BITS;
+
+    if (ho->drift_valid) {
+        ho->dac += ho->drift;
+    }
+
+    /* Clamp the value to the DAC limits */
+    if (ho->dac > max) {
+        ho->dac = max;
+    } else if (ho->dac < 0) {
+        ho->dac = 0;
+    }
+
+    /* Rounded to the DAC resolution (including the DAC dither fractional bits). */
+    vctcxo_trim_dac_write_frac((uint32_t)((ho->dac + (1 << (HOLDOVER_FRAC_BITS - DAC_FRAC_BITS - 1))) >>
+                                          (HOLDOVER_FRAC_BITS - DAC_FRAC_BITS)));
+}
+#endif
+
+#ifdef CONFIG_COARSE_TUNE_SEARCH
+#ifndef CSR_PPS_TIMESTAMP_BASE
+#error "COARSE_TUNE_SEARCH requires the continuous-count mode (errors within tolerance reported)"
+#endif
+
+/* Resets the COARSE_TUNE_SEARCH state. */
+static void coarse_search_reset(coarse_search_t *search)
+{
+    search->iter       = 0;
+    search->settle     = 0;
+    search->neg_valid  = false;
+    search->pos_valid  = false;
+    search->neg.x      = 0;
+    search->neg.y      = 0;
+    search->pos        = search->neg;
+    search->lo         = search->neg;
+    search->hi         = search->neg;
+    search->settle_sum = 0;
+}
+
+/* Ends the COARSE_TUNE_SEARCH: the FINE_TUNE slope is taken from the
+ * widest-spaced measurements (near convergence the last two are a few DAC
+ * counts apart: their slope is dominated by the count noise) and the
+ * y-intercept is the zero error DAC value estimated with it from the
+ * COARSE_SEARCH_SETTLE 1s errors summed at the last DAC value (a single 1s
+ * error within tolerance is only known to +/-1 count).
+ *
+ * @param search  The search state.
+ * @param line    The calibration line (last two measurements, local slope).
+ * @param dac_max The maximum trim DAC value.
+ */
+static void coarse_search_done(const coarse_search_t *search, line_t *line, uint16_t dac_max)
+{
+    int32_t y;
+
+    if ((search->hi.y != search->lo.y) && (search->hi.x != search->lo.x)) {
+        line->slope = line_slope((int32_t)search->hi.y - (int32_t)search->lo.y,
+                                 search->hi.x - search->lo.x);
+    }
+
+    y = (int32_t)line->point[1].y - slope_apply(search->settle_sum, line->slope) / COARSE_SEARCH_SETTLE;
+    if (y > dac_max) {
+        y = dac_max;
+    } else if (y < 0) {
+        y = 0;
+    }
+    line->y_intercept = (uint16_t)y;
+}
+
+/* Starts settling at the converged DAC value (first 1s error measured). */
+static void coarse_search_settle(coarse_search_t *search, int32_t error)
+{
+    search->settle     = 1;
+    search->settle_sum = error;
+}
 
-#include <generated/soc.h>
-#include <generated/mem.h>
-#include <generated/csr.h>
+/* Runs one step of the COARSE_TUNE_SEARCH: safeguarded secant search of the
+ * trim DAC value giving a zero 1s error. The secant estimate is replaced by a
+ * bisection whenever it falls outside of the known bracket.
+ *
+ * @param search  The search state.
+ * @param line    The calibration line (last two measurements, slope, intercept).
+ * @param error   The 1s PPS error measured at the current trim DAC value.
+ * @param in_tol  True when the 1s error is within tolerance.
+ * @param dac_max The maximum trim DAC value.
+ * @return true when the search is done and line holds the calibration.
+ */
+static bool coarse_search_step(coarse_search_t *search, line_t *line,
+                               int32_t error, bool in_tol, uint16_t dac_max)
+{
+    int32_t next;
+    int32_t dx;
 
-#include "vctcxo_tamer.h"
+    /* Settling at the converged DAC value: sum the (continuous) 1s errors. */
+    if (search->settle > 0) {
+        search->settle_sum += error;
+        if (++search->settle >= COARSE_SEARCH_SETTLE) {
+            coarse_search_done(search, line, dac_max);
+            return true;
+        }
+        return false;
+    }
 
-/*-----------------------------------------------------------------------*/
-/* Constants                                                             */
-/*-----------------------------------------------------------------------*/
+    /* Record the measurement. */
+    line->point[0]   = line->point[1];
+    line->point[1].x = error;
+    line->point[1].y = vctcxo_trim_dac_value;
+    search->iter++;
 
-//#define VCTCXO_DEBUG
+    if (error < 0) {
+        search->neg       = line->point[1];
+        search->neg_valid = true;
+    } else {
+        search->pos       = line->point[1];
+        search->pos_valid = true;
+    }
+    if ((search->iter == 1) || (line->point[1].y < search->lo.y)) {
+        search->lo = line->point[1];
+    }
+    if ((search->iter == 1) || (line->point[1].y > search->hi.y)) {
+        search->hi = line->point[1];
+    }
 
-#define VCTCXO_DEFAULT_DAC_VALUE 0x77FA
+    /* First measurement: step up (a higher DAC value usually means a higher
+       frequency, the secant handles the opposite case). */
+    if (search->iter == 1) {
+        next = (int32_t)vctcxo_trim_dac_value + ((error < 0) ? COARSE_SEARCH_STEP : -COARSE_SEARCH_STEP);
+    } else {
+        dx = line->point[1].x - line->point[0].x;
 
-/*-----------------------------------------------------------------------*/
-/* Global Variables                                                      */
-/*-----------------------------------------------------------------------*/
+        /* Local slope from the last two measurements. */
+        if (dx != 0) {
+            line->slope = line_slope((int32_t)line->point[1].y - (int32_t)line->point[0].y, dx);
+        }
 
-struct vctcxo_tamer_pkt_buf vctcxo_tamer_pkt;
+        /* Converged (a slope is required for FINE_TUNE). */
+        if ((in_tol && (dx != 0)) || (search->iter >= COARSE_SEARCH_MAX_ITER)) {
+            coarse_search_settle(search, error);
+            return false;
+        }
 
-/*-----------------------------------------------------------------------*/
-/* Helpers                                                               */
-/*-----------------------------------------------------------------------*/
+        /* Secant estimate, or keep stepping when both errors are equal. */
+        if (dx != 0) {
+            next = (int32_t)line->point[1].y - slope_apply(line->point[1].x, line->slope);
+        } else {
+            next = (int32_t)line->point[1].y + (int32_t)line->point[1].y - (int32_t)line->point[0].y;
+        }
 
-/* Simple local delay in milliseconds using a busy loop.
- * We avoid using external busy_wait() to prevent toolchain confusion.
- * Timing is not very accurate but should be enough in this case. */
-static void delay_ms(uint32_t ms)
-{
-    /* Use CONFIG_CLOCK_FREQUENCY from generated/soc.h.
-     * SERV is a bit-serial core. Instructions take 32+ cycles.
-     * Empirical testing shows the loop takes ~320 cycles/iter. */
-    uint32_t cycles_per_ms = CONFIG_CLOCK_FREQUENCY / 1000u;
-    uint32_t iters_per_ms = (cycles_per_ms / 320u) ? (cycles_per_ms / 320u) : 1u;
-    for (uint32_t m = 0; m < ms; m++) {
-        for (volatile uint32_t i = 0; i < iters_per_ms; i++) {
-            __asm__ volatile ("nop");
+        /* Bisection when the estimate leaves the bracket. */
+        if (search->neg_valid && search->pos_valid) {
+            int32_t lo = (search->neg.y < search->pos.y) ? search->neg.y : search->pos.y;
+            int32_t hi = (search->neg.y < search->pos.y) ? search->pos.y : search->neg.y;
+            if ((next <= lo) || (next >= hi)) {
+                next = (lo + hi) / 2;
+            }
         }
     }
+
+    /* Clamp the value to the DAC limits */
+    if (next > dac_max) {
+        next = dac_max;
+    } else if (next < 0) {
+        next = 0;
+    }
+
+    /* No further progress possible: use the current calibration. */
+    if ((next == line->point[1].y) && (search->iter > 1)) {
+        coarse_search_settle(search, error);
+        return false;
+    }
+
+    vctcxo_trim_dac_write((uint16_t)next);
+
+    return false;
+}
+#endif
+
+#ifdef FINE_TUNE_PI_LOOP
+/* Resets the FINE_TUNE PI loop state. */
+static void pi_loop_reset(pi_loop_t *pi)
+{
+    pi->phase = 0;
+
+#ifdef CONFIG_FINE_TUNE_PHASE
+    /* Measure the phase from zero to avoid a large initial pull. */
+    pps_timestamp_realign();
+#endif
 }
 
-/* Adjusts the trim DAC value based on error, slope, and scale.
+/* Runs one step of the FINE_TUNE PI (type-2 PLL) loop.
  *
- * @param error The PPS error value.
+ * The trim DAC integrates the frequency term and the phase term adds the
+ * second integration, so both the frequency and the phase error are driven
+ * to zero:
+ *   dac -= slope * (Kp * error + Ki * phase)
+ *
+ * The phase is either the accumulated 1s error (CONFIG_FINE_TUNE_PI) or the
+ * PPS phase error measured against the local 1s epoch
+ * (CONFIG_FINE_TUNE_PHASE, phase lock).
+ *
+ * @param pi    The PI loop state.
+ * @param error The 1s PPS error value.
+ * @param phase The measured PPS phase error (ignored for CONFIG_FINE_TUNE_PI).
  * @param slope The calibration slope.
- * @param scale The scaling factor (1, 10, or 100).
  */
-static void adjust_trim_dac(int32_t error, float slope, int scale) {
-    /* Compute new trim DAC value */
-    /* Use signed 32-bit integer for calculation to handle negatives */
-    int32_t new_value = (int32_t)vctcxo_trim_dac_value -
-            (int32_t)(lroundf((float)error * slope) / scale);
+static void pi_loop_update(pi_loop_t *pi, int32_t error, int32_t phase, slope_t slope)
+{
+    int32_t u;
 
-    /* Clamp the value to the DAC limits */
-    if (new_value > CONFIG_DAC_MAX) {
-        new_value = CONFIG_DAC_MAX;
-    } else if (new_value < 0) {
-        new_value = 0;
+#ifdef CONFIG_FINE_TUNE_PHASE
+    pi->phase = phase;
+#else
+    (void)phase;
+    pi->phase += error;
+#endif
+
+    /* Clamp the phase term (anti-windup). */
+    if (pi->phase > PI_PHASE_MAX) {
+        pi->phase = PI_PHASE_MAX;
+    } else if (pi->phase < -PI_PHASE_MAX) {
+        pi->phase = -PI_PHASE_MAX;
+    }
+
+    /* Combine both terms scaled by 2^KI_SHIFT and let adjust_trim_dac_shift()
+       do the slope conversion and scaling back (both gains lowered with the
+       10 MHz reference). */
+    u = error * (1 << (CONFIG_PI_KI_SHIFT - CONFIG_PI_KP_SHIFT)) + pi->phase;
+
+    adjust_trim_dac_shift(u, slope, CONFIG_PI_KI_SHIFT + (ref_mode() ? CONFIG_REF_SHIFT : 0));
+}
+#endif
+
+#ifdef CONFIG_FINE_TUNE_ADAPTIVE
+/* Resets the FINE_TUNE adaptive interval state (back to 1s windows). */
+static void adaptive_reset(adaptive_t *ad)
+{
+    ad->level      = 0;
+    ad->count      = 0;
+    ad->sum        = 0;
+    ad->last       = 0;
+    ad->last_valid = false;
+    ad->var        = 0;
+}
+
+/* Runs one step of the FINE_TUNE adaptive interval loop.
+ *
+ * The 1s errors (zero dead-time, continuous-count mode) are summed over a
+ * window of 4^level seconds, so the window error is exact for any length,
+ * including lengths beyond 100s. At the end of the window:
+ * - Mean error well above the 1s noise (loop pulling in): full correction
+ *   and shorter window.
+ * - Mean error within the noise (loop stable): half correction and longer
+ *   window, averaging the noise down further.
+ * The noise is the running 2-sample variance of the 1s error, measured on
+ * samples not affected by a DAC update.
+ *
+ * @param ad    The adaptive interval state.
+ * @param error The 1s PPS error value.
+ * @param slope The calibration slope.
+ */
+static void adaptive_update(adaptive_t *ad, int32_t error, slope_t slope)
+{
+    const uint16_t n = 1 << (2 * ad->level);
+    int64_t d, var, sum2, noise2;
+
+    /* Running variance: var(e[k] - e[k-1]) / 2 (Q8, floor of 1 count^2). */
+    if (ad->last_valid) {
+        d = error - ad->last;
+        if (d > ADAPTIVE_ERROR_MAX) {
+            d = ADAPTIVE_ERROR_MAX;
+        } else if (d < -ADAPTIVE_ERROR_MAX) {
+            d = -ADAPTIVE_ERROR_MAX;
+        }
+        ad->var += ((d * d << 7) - ad->var) >> ADAPTIVE_VAR_SHIFT;
+    }
+    ad->last       = error;
+    ad->last_valid = true;
+
+    ad->sum += error;
+    if (++ad->count < n) {
+        return;
     }
 
-    /* Update global variable */
-    vctcxo_trim_dac_value = (uint16_t)new_value;
+    /* End of window: compare the window error to the noise over n seconds
+       (sum^2 vs K^2 * n * var). */
+    var    = (ad->var > (1 << 8)) ? ad->var : (1 << 8);
+    sum2   = ((int64_t)ad->sum * ad->sum) << 8;
+    noise2 = n * var;
+
+    if ((ad->sum > (ADAPTIVE_ERROR_MAX << 7)) || (ad->sum < -(ADAPTIVE_ERROR_MAX << 7)) ||
+        (sum2 > ADAPTIVE_DOWN_K2 * noise2)) {
+        adjust_trim_dac_shift(ad->sum, slope, 2 * ad->level);
+        ad->last_valid = false;
+        if (ad->level > 0) {
+            ad->level--;
+        }
+    } else {
+        if (ad->sum != 0) {
+            adjust_trim_dac_shift(ad->sum, slope, 2 * ad->level + 1);
+            ad->last_valid = false;
+        }
+        if ((sum2 <= ADAPTIVE_UP_K2 * noise2) && (ad->level < CONFIG_ADAPTIVE_MAX_LEVEL)) {
+            ad->level++;
+        }
+    }
 
-    /* Write value to VCTCXO Tamer. */
-    vctcxo_trim_dac_write(vctcxo_trim_dac_value);
+    ad->count = 0;
+    ad->sum   = 0;
 }
+#endif
 
 /*-----------------------------------------------------------------------*/
-/* Main                                                                  */
+/* Interrupts                                                            */
 /*-----------------------------------------------------------------------*/
-int main(void)
+
+#ifdef VCTCXO_TAMER_IRQ_INTERRUPT
+/* CPU interrupt handler (called from crt0). */
+__attribute__((section(".text.isr")))
+void isr(void)
+{
+    uint32_t start = prof_cycles();
+    uint32_t irqs  = irq_pending() & irq_getmask();
+
+#ifdef PPS_TIMESTAMP_INTERRUPT
+    /* New PPS timestamp (continuous-count mode). */
+    if (irqs & (1 << PPS_TIMESTAMP_INTERRUPT)) {
+        prof_pps_mark();
+        pps_timestamp_ev_pending_write(pps_timestamp_ev_pending_read());
+        pps_timestamp_isr(&vctcxo_tamer_pkt);
+    }
+#endif
+
+#ifdef CYCLE_COUNTER_INTERRUPT
+    /* Cycle counter compare (delay_ms() wake-up). */
+    if (irqs & (1 << CYCLE_COUNTER_INTERRUPT)) {
+        cycle_counter_ev_pending_write(cycle_counter_ev_pending_read());
+    }
+#endif
+
+    if (irqs & (1 << VCTCXO_TAMER_IRQ_INTERRUPT)) {
+        uint32_t pending = vctcxo_tamer_irq_ev_pending_read();
+
+        /* PPS measurement ready (Tamer IRQ is disabled/cleared by the handler). */
+        if (pending & (1 << CSR_VCTCXO_TAMER_IRQ_EV_PENDING_PPS_OFFSET)) {
+            prof_pps_mark();
+            vctcxo_tamer_isr(&vctcxo_tamer_pkt);
+        }
+
+        /* Long window completed. */
+        if (pending & (1 << CSR_VCTCXO_TAMER_IRQ_EV_PENDING_LONG_OFFSET)) {
+            vctcxo_tamer_long_isr(&vctcxo_tamer_pkt);
+        }
+
+        /* Enable/PPS active change or long window completed: the main loop
+           samples them once woken up, flag the event so that it does not go
+           back to sleep first. */
+        if (pending & ((1 << CSR_VCTCXO_TAMER_IRQ_EV_PENDING_ENABLE_OFFSET) |
+                       (1 << CSR_VCTCXO_TAMER_IRQ_EV_PENDING_PPS_ACTIVE_OFFSET) |
+                       (1 << CSR_VCTCXO_TAMER_IRQ_EV_PENDING_LONG_OFFSET))) {
+            vctcxo_tamer_event = true;
+        }
+        vctcxo_tamer_irq_ev_pending_write(pending);
+    }
+
+    prof_record(PROF_SLOT_ISR, start);
+}
+#endif
+
+/* Sleeps until the next VCTCXO Tamer event (PPS measurement, enable or PPS
+ * active change).
+ * Interrupts are masked while checking for pending work (measurement ready
+ * or event flagged by the ISR since the last sleep) so that an event
+ * occurring just before wfi is not missed (wfi still wakes up on a pending
+ * interrupt when they are masked). The event flag is consumed here: an event
+ * flagged after the main loop sampled the status only costs one more loop
+ * iteration. Without CPU interrupt support, returns immediately and the main
+ * loop polls the Tamer instead. */
+static void wait_for_event(void)
 {
-#ifdef VCTCXO_DEBUG
-    uart_init();
-    puts("\nLimePSB-RPCM GPSDO Firmware.\n");
+#ifdef VCTCXO_TAMER_IRQ_INTERRUPT
+    irq_setie(0);
+    if (!vctcxo_tamer_pkt.ready && !vctcxo_tamer_event) {
+        __asm__ volatile ("wfi");
+    }
+    vctcxo_tamer_event = false;
+    irq_setie(1);
 #endif
+}
 
+/*-----------------------------------------------------------------------*/
+/* Main                                                                  */
+/*-----------------------------------------------------------------------*/
+int main(void)
+{
     /* Trim DAC constants. */
 #ifdef CONFIG_DAC_MAX
     const uint16_t trimdac_min = 0x0000;         /* Decimal value = 0. */
@@ -102,12 +1549,71 @@ int main(void)
     const uint16_t trimdac_max = 0xFFFF; /* Decimal value = 65535. */
 #endif
 
-    /* Trim DAC calibration line. */
-    line_t trimdac_cal_line;
+    /* Trim DAC calibration line. The control state below is static: held in
+       .bss (in the SRAM budget check) rather than on the stack. */
+    static line_t trimdac_cal_line;
 
     /* VCTCXO Tamer Tune State machine. */
     state_t tune_state = COARSE_TUNE_MIN;
 
+#ifdef CONFIG_COARSE_TUNE_SEARCH
+    /* COARSE_TUNE_SEARCH state. */
+    static coarse_search_t coarse_search;
+    coarse_search_reset(&coarse_search);
+#endif
+
+#ifdef FINE_TUNE_PI_LOOP
+    /* FINE_TUNE PI loop. */
+    static pi_loop_t fine_tune_pi;
+    pi_loop_reset(&fine_tune_pi);
+#endif
+
+#ifdef CONFIG_FINE_TUNE_ADAPTIVE
+    /* FINE_TUNE adaptive interval loop. */
+    static adaptive_t fine_tune_adaptive;
+    adaptive_reset(&fine_tune_adaptive);
+#endif
+
+#ifdef FINE_TUNE_WINDOWS
+    /* FINE_TUNE proportional loop window slopes (set on FINE_TUNE entry). */
+    static window_slopes_t fine_tune_slopes;
+    window_slopes_reset(&fine_tune_slopes, 0);
+#endif
+
+#ifdef CONFIG_HOLDOVER
+    /* HOLDOVER drift model. */
+    static holdover_t holdover;
+    holdover_reset(&holdover);
+#endif
+
+#ifdef CONFIG_TEMP_COMP
+    /* Temperature compensation table (learned online, kept across enables). */
+    static temp_comp_t temp_comp;
+    temp_comp_reset(&temp_comp);
+#endif
+
+#ifdef CONFIG_OUTLIER_WINDOW
+    /* FINE_TUNE outlier filter. */
+    static outlier_filter_t outlier_filter;
+    outlier_filter.rejected = 0;
+    outlier_filter_reset(&outlier_filter);
+#endif
+
+#ifdef CSR_LOCK_QUALITY_BASE
+    /* Lock quality (FINE_TUNE statistics and lock decision). */
+    static lock_quality_t lock_quality;
+    lock_quality_reset(&lock_quality);
+#endif
+
+#ifdef CSR_PPS_SELECT_BASE
+    /* PPS source voting (starts on source 0). */
+    static pps_vote_t pps_vote;
+    pps_vote.sel      = 0;
+    pps_vote.switches = 0;
+    pps_vote_reset(&pps_vote);
+    pps_select_source_write(0);
+#endif
+
     /* Set the known/default values of the trim DAC cal line. */
     trimdac_cal_line.point[0].x  = 0;
     trimdac_cal_line.point[0].y  = trimdac_min;
@@ -116,13 +1622,59 @@ int main(void)
     trimdac_cal_line.slope       = 0;
     trimdac_cal_line.y_intercept = 0;
     vctcxo_tamer_pkt.ready       = false;
+    vctcxo_tamer_pkt.pps_long_error_flag = false;
+    vctcxo_tamer_pkt.pps_long_ready      = false;
+    vctcxo_tamer_pkt.pps_windows         = 0;
 
     uint8_t vctcxo_tamer_en     = 0;
     uint8_t vctcxo_tamer_en_old = 0;
+    bool    reacquire           = false;
+#ifdef CONFIG_OUTLIER_WINDOW
+    bool    long_only           = false; /* Long window only packet: no new 1s error to filter. */
+#endif
+#ifdef CSR_CONFIG_UPDATE_BASE
+    uint8_t  config_gen         = 0; /* Generation/1s target the calibration is at. */
+    uint32_t config_target      = 0;
+#endif
+#ifdef CSR_PROFILER_BASE
+    uint16_t prof_count         = 0;
+#endif
 
     /* Set Default VCTCXO DAC value. */
     vctcxo_trim_dac_write(VCTCXO_DEFAULT_DAC_VALUE);
 
+#ifdef CSR_PROFILER_BASE
+    /* Measure delay_ms(1) (cycle counter wait and wake-up overhead). */
+    {
+        uint32_t start = prof_cycles();
+        delay_ms(1);
+        prof_record(PROF_SLOT_DELAY_MS, start);
+    }
+#endif
+
+#ifdef VCTCXO_TAMER_IRQ_INTERRUPT
+    /* Enable VCTCXO Tamer interrupts (PPS measurement, enable and PPS active
+       change, long window). In continuous-count mode, PPS measurements
+       (including the long window) come from the PPS timestamps. */
+    vctcxo_tamer_irq_ev_pending_write(vctcxo_tamer_irq_ev_pending_read());
+#ifdef PPS_TIMESTAMP_INTERRUPT
+    vctcxo_tamer_irq_ev_enable_write(
+        (1 << CSR_VCTCXO_TAMER_IRQ_EV_ENABLE_ENABLE_OFFSET) |
+        (1 << CSR_VCTCXO_TAMER_IRQ_EV_ENABLE_PPS_ACTIVE_OFFSET));
+    pps_timestamp_ev_pending_write(pps_timestamp_ev_pending_read());
+    pps_timestamp_ev_enable_write(1 << CSR_PPS_TIMESTAMP_EV_ENABLE_PPS_OFFSET);
+    irq_setmask(irq_getmask() | (1 << PPS_TIMESTAMP_INTERRUPT));
+#else
+    vctcxo_tamer_irq_ev_enable_write(
+        (1 << CSR_VCTCXO_TAMER_IRQ_EV_ENABLE_PPS_OFFSET) |
+        (1 << CSR_VCTCXO_TAMER_IRQ_EV_ENABLE_ENABLE_OFFSET) |
+        (1 << CSR_VCTCXO_TAMER_IRQ_EV_ENABLE_PPS_ACTIVE_OFFSET) |
+        (1 << CSR_VCTCXO_TAMER_IRQ_EV_ENABLE_LONG_OFFSET));
+#endif
+    irq_setmask(irq_getmask() | (1 << VCTCXO_TAMER_IRQ_INTERRUPT));
+    irq_setie(1);
+#endif
+
     /* ---------- */
     /*  Main Loop */
     /* ---------- */
@@ -132,32 +1684,242 @@ int main(void)
         vctcxo_tamer_en_old = vctcxo_tamer_en;
         vctcxo_tamer_en     = (vctcxo_tamer_status_read() & 0b1);
 
+#ifndef VCTCXO_TAMER_IRQ_INTERRUPT
+#ifdef CSR_PPS_TIMESTAMP_BASE
+        /* Check for a new PPS timestamp. */
+        if (pps_timestamp_ev_pending_read() != 0) {
+            prof_pps_mark();
+            pps_timestamp_ev_pending_write(pps_timestamp_ev_pending_read());
+            pps_timestamp_isr(&vctcxo_tamer_pkt);
+        }
+#else
         /* Check VCTCXO Tamer Error Status. */
         if (vctcxo_tamer_read(VT_STAT_ADDR) != 0) {
+            prof_pps_mark();
             vctcxo_tamer_isr(&vctcxo_tamer_pkt);
         }
 
+        /* Check for a completed long window. */
+        vctcxo_tamer_long_isr(&vctcxo_tamer_pkt);
+#endif
+#endif
+
+        reacquire = false;
+#ifdef CSR_CONFIG_UPDATE_BASE
+        /* Configuration update (new targets/tolerances applied by the gateware
+           on a PPS, config_gen handshake): once calibrated, the slope is
+           rescaled to the new 1s target and FINE_TUNE re-acquires from the
+           next PPS with the current trim DAC value. During the coarse tune,
+           the calibration restarts (as on enable). */
+        if (vctcxo_tamer_en && vctcxo_tamer_en_old) {
+            uint8_t gen = (uint8_t)config_update_gen_read();
+
+            if (gen != config_gen) {
+                uint32_t target = config_update_target_1s_read();
+
+                if (((tune_state == FINE_TUNE) || (tune_state == HOLDOVER)) &&
+                    (config_target != 0) && (target != 0)) {
+                    calibration_rescale(&trimdac_cal_line, config_target, target);
+#ifdef CSR_LOCK_QUALITY_BASE
+                    lock_quality_reset(&lock_quality);
+#endif
+#ifdef CSR_VCTCXO_TAMER_LONG_BASE
+                    vctcxo_tamer_long_restart_write(1);
+#endif
+                    reacquire = (tune_state == FINE_TUNE);
+                } else {
+                    vctcxo_tamer_en_old = 0;
+                }
+                config_gen    = gen;
+                config_target = target;
+            }
+        }
+#endif
+
         /* Enable or disable VCTCXO Tamer module depending on enable signal. */
         if (vctcxo_tamer_en_old != vctcxo_tamer_en) {
             /* Enable. */
             if (vctcxo_tamer_en == 0x01) {
-                vctcxo_tamer_init();
-                tune_state = COARSE_TUNE_MIN;
-                vctcxo_tamer_pkt.ready = true;
+#ifdef CSR_CONFIG_UPDATE_BASE
+                config_gen    = (uint8_t)config_update_gen_read();
+                config_target = config_update_target_1s_read();
+#endif
+                pps_timestamp_reset();
+#ifdef CONFIG_HOLDOVER
+                holdover_reset(&holdover);
+#endif
+#ifdef CSR_LOCK_QUALITY_BASE
+                lock_quality_reset(&lock_quality);
+#endif
+#ifdef CSR_PPS_SELECT_BASE
+                pps_vote_reset(&pps_vote);
+#endif
+#ifdef CONFIG_TEMP_COMP
+                temp_comp.ref_valid = false;
+#endif
+#ifdef CONFIG_OUTLIER_WINDOW
+                outlier_filter_reset(&outlier_filter);
+#endif
+
+                /* Warm start: restore the saved calibration and go straight
+                   to FINE_TUNE, waiting for the first measurement. */
+                if (calibration_warm_start(&trimdac_cal_line, trimdac_max)) {
+                    vctcxo_tamer_pkt.ready = false;
+                    vctcxo_tamer_init();
+                    vctcxo_tamer_write(VT_STATE_ADDR, 0x01);
+#ifdef FINE_TUNE_PI_LOOP
+                    pi_loop_reset(&fine_tune_pi);
+#endif
+#ifdef CONFIG_FINE_TUNE_ADAPTIVE
+                    adaptive_reset(&fine_tune_adaptive);
+#endif
+#ifdef FINE_TUNE_WINDOWS
+                    window_slopes_reset(&fine_tune_slopes, trimdac_cal_line.slope);
+#endif
+                    tune_state = FINE_TUNE;
+                }
+#ifdef CONFIG_COARSE_TUNE_SEARCH
+                /* Cold start: search from the default DAC value, waiting for
+                   the first measurement. */
+                else {
+                    vctcxo_trim_dac_write(VCTCXO_DEFAULT_DAC_VALUE);
+                    coarse_search_reset(&coarse_search);
+                    vctcxo_tamer_pkt.ready = false;
+                    vctcxo_tamer_init();
+                    tune_state = COARSE_TUNE_SEARCH;
+                }
+#else
+                /* Cold start: full coarse calibration. */
+                else {
+                    vctcxo_tamer_init();
+                    tune_state = COARSE_TUNE_MIN;
+                    vctcxo_tamer_pkt.ready = true;
+                }
+#endif
             }
             /* Disable. */
             else {
                 vctcxo_tamer_dis();
+#ifdef CSR_LOCK_QUALITY_BASE
+                lock_quality_reset(&lock_quality);
+#endif
                 tune_state = COARSE_TUNE_MIN;
                 vctcxo_tamer_pkt.ready = false;
             }
         }
 
+#ifdef CSR_PPS_SELECT_BASE
+        /* Selected PPS source lost: switch to another one (no HOLDOVER, not
+           with the 10 MHz reference). */
+        if (vctcxo_tamer_en && !ref_mode() && !pps_is_active() && pps_vote_failover(&pps_vote)) {
+            vctcxo_tamer_pkt.ready = false;
+        }
+#endif
+
+        /* PPS lost: do not act on the counts, and go to HOLDOVER once the
+           VCTCXO is calibrated. */
+        if (vctcxo_tamer_en && !pps_is_active()) {
+            vctcxo_tamer_pkt.ready = false;
+            if (tune_state == FINE_TUNE) {
+                vctcxo_tamer_write(VT_STATE_ADDR, 0x02);
+#ifdef CONFIG_HOLDOVER
+                holdover_enter(&holdover);
+#endif
+#ifdef CSR_LOCK_QUALITY_BASE
+                lock_quality_reset(&lock_quality);
+#endif
+                tune_state = HOLDOVER;
+            }
+        }
+        /* PPS back (or configuration update): re-acquire in FINE_TUNE with the
+           current calibration. */
+        else if ((tune_state == HOLDOVER) || reacquire) {
+            vctcxo_tamer_write(VT_STATE_ADDR, 0x01);
+            pps_timestamp_reset();
+#ifdef CONFIG_HOLDOVER
+            holdover_resume(&holdover);
+#endif
+#ifdef CONFIG_OUTLIER_WINDOW
+            outlier_filter_reset(&outlier_filter);
+#endif
+#ifdef FINE_TUNE_PI_LOOP
+            pi_loop_reset(&fine_tune_pi);
+#endif
+#ifdef CONFIG_FINE_TUNE_ADAPTIVE
+            adaptive_reset(&fine_tune_adaptive);
+#endif
+#ifdef FINE_TUNE_WINDOWS
+            window_slopes_reset(&fine_tune_slopes, trimdac_cal_line.slope);
+#endif
+            vctcxo_tamer_pkt.ready = false;
+            vctcxo_tamer_reset_counters(true);
+            vctcxo_tamer_reset_counters(false);
+            vctcxo_tamer_enable_isr(true);
+            tune_state = FINE_TUNE;
+        }
+
+#ifdef CONFIG_TEMP_COMP
+        /* Temperature feed-forward: correct the DAC for temperature changes
+           before they show up as PPS error (HOLDOVER: in the drift model). */
+        if ((tune_state == FINE_TUNE) || (tune_state == HOLDOVER)) {
+            int32_t ff = temp_comp_feedforward(&temp_comp);
+            if (ff != 0) {
+#ifdef CONFIG_HOLDOVER
+                if (tune_state == HOLDOVER) {
+                    holdover.dac += (int64_t)ff << HOLDOVER_FRAC_BITS;
+                } else {
+                    offset_trim_dac(ff);
+                }
+#else
+                offset_trim_dac(ff);
+#endif
+            }
+        }
+#endif
+
+        /* Long window out of tolerance with no Tamer measurement pending (the
+           Tamer is within tolerance): FINE_TUNE correction on its own. */
+#ifdef CONFIG_OUTLIER_WINDOW
+        long_only = false;
+#endif
+        if (vctcxo_tamer_pkt.pps_long_ready) {
+            vctcxo_tamer_pkt.pps_long_ready = false;
+#if !defined(FINE_TUNE_PI_LOOP) && !defined(CONFIG_FINE_TUNE_ADAPTIVE)
+            if (!vctcxo_tamer_pkt.ready && (tune_state == FINE_TUNE)) {
+                vctcxo_tamer_pkt.pps_1s_error_flag   = false;
+                vctcxo_tamer_pkt.pps_10s_error_flag  = false;
+                vctcxo_tamer_pkt.pps_100s_error_flag = false;
+                vctcxo_tamer_pkt.pps_windows         = 0;
+                vctcxo_tamer_pkt.ready = true;
+#ifdef CONFIG_OUTLIER_WINDOW
+                long_only = true;
+#endif
+            }
+#endif
+        }
+
         /* VCTCXO Tamer Calibration FSM. */
         if (vctcxo_tamer_pkt.ready)
         {
+            const state_t prof_state = tune_state;
+            uint32_t      prof_start = prof_cycles();
+
             vctcxo_tamer_pkt.ready = false;
 
+#ifdef CSR_PPS_SELECT_BASE
+            /* Per-source statistics and source selection (from the next
+               PPS on). */
+            if (!ref_mode()) {
+                pps_vote_update(&pps_vote);
+            }
+#endif
+
+            /* Record the measurement with the DAC value it was taken at (no
+               measurement yet when coarse tune is kicked off on enable). */
+            if (tune_state != COARSE_TUNE_MIN) {
+                history_push(&vctcxo_tamer_pkt, tune_state);
+            }
+
             switch (tune_state)
             {
 
@@ -165,9 +1927,6 @@ int main(void)
             /* COARSE TUNE MIN State */
             /* --------------------- */
             case COARSE_TUNE_MIN:
-#ifdef VCTCXO_DEBUG
-                puts("\nCOARSE_TUNE_MIN\n");
-#endif
                 /* Set trim DAC to minimum value. */
                 vctcxo_trim_dac_write(trimdac_min);
                 vctcxo_tamer_reset_counters(true);
@@ -181,9 +1940,6 @@ int main(void)
             /* COARSE TUNE MAX State   */
             /* ----------------------- */
             case COARSE_TUNE_MAX:
-#ifdef VCTCXO_DEBUG
-                puts("\nCOARSE_TUNE_MAX\n");
-#endif
                 /* We have the error from the minimum DAC setting, store it as
                    the 'x' coordinate for the first point. */
                 trimdac_cal_line.point[0].x = vctcxo_tamer_pkt.pps_1s_error;
@@ -202,9 +1958,6 @@ int main(void)
             /* ---------------------- */
 
             case COARSE_TUNE_DONE:
-#ifdef VCTCXO_DEBUG
-                puts("\nCOARSE_TUNE_DONE\n");
-#endif
                 /* Write status to state register. */
                 vctcxo_tamer_write(VT_STATE_ADDR, 0x01);
 
@@ -217,13 +1970,13 @@ int main(void)
                    the X axis. We want a PPM of zero, which ideally corresponds
                    to the y-intercept of the line. */
                 if ((trimdac_cal_line.point[1].x - trimdac_cal_line.point[0].x) != 0) {
-                    trimdac_cal_line.slope = (
-                        (float)(trimdac_cal_line.point[1].y - trimdac_cal_line.point[0].y) /
-                        (float)(trimdac_cal_line.point[1].x - trimdac_cal_line.point[0].x));
+                    trimdac_cal_line.slope = line_slope(
+                        (int32_t)(trimdac_cal_line.point[1].y - trimdac_cal_line.point[0].y),
+                        trimdac_cal_line.point[1].x - trimdac_cal_line.point[0].x);
 
                     trimdac_cal_line.y_intercept = (
                         trimdac_cal_line.point[0].y -
-                        (uint16_t)(lroundf(trimdac_cal_line.slope * (float)trimdac_cal_line.point[0].x)));
+                        (uint16_t)(slope_apply(trimdac_cal_line.point[0].x, trimdac_cal_line.slope)));
                 } else {
                     /* Handle division by zero (rare, but set to default). */
                     trimdac_cal_line.y_intercept = VCTCXO_DEFAULT_DAC_VALUE;
@@ -232,40 +1985,126 @@ int main(void)
                 /* Set the trim DAC count to the y-intercept. */
                 vctcxo_trim_dac_write(trimdac_cal_line.y_intercept);
 
+                /* Publish the calibration for later warm starts. */
+                calibration_publish(&trimdac_cal_line);
+
+#ifdef FINE_TUNE_PI_LOOP
+                pi_loop_reset(&fine_tune_pi);
+#endif
+#ifdef CONFIG_FINE_TUNE_ADAPTIVE
+                adaptive_reset(&fine_tune_adaptive);
+#endif
+#ifdef FINE_TUNE_WINDOWS
+                window_slopes_reset(&fine_tune_slopes, trimdac_cal_line.slope);
+#endif
+
                 /* Set next interrupt state. */
                 tune_state = FINE_TUNE;
 
                 break;
 
+#ifdef CONFIG_COARSE_TUNE_SEARCH
+            /* ------------------------ */
+            /* COARSE TUNE SEARCH State */
+            /* ------------------------ */
+            case COARSE_TUNE_SEARCH:
+                /* Secant/bisection steps over narrowing DAC ranges until the
+                   1s error is within tolerance, then a short settle averaging
+                   the 1s errors. */
+                if (coarse_search_step(&coarse_search, &trimdac_cal_line,
+                        vctcxo_tamer_pkt.pps_1s_error,
+                        !vctcxo_tamer_pkt.pps_1s_error_flag, trimdac_max)) {
+                    /* Write status to state register. */
+                    vctcxo_tamer_write(VT_STATE_ADDR, 0x01);
+
+                    /* Set the trim DAC count to the y-intercept. */
+                    vctcxo_trim_dac_write(trimdac_cal_line.y_intercept);
+
+                    /* Publish the calibration for later warm starts. */
+                    calibration_publish(&trimdac_cal_line);
+
+#ifdef FINE_TUNE_PI_LOOP
+                    pi_loop_reset(&fine_tune_pi);
+#endif
+#ifdef CONFIG_FINE_TUNE_ADAPTIVE
+                    adaptive_reset(&fine_tune_adaptive);
+#endif
+#ifdef FINE_TUNE_WINDOWS
+                    window_slopes_reset(&fine_tune_slopes, trimdac_cal_line.slope);
+#endif
+
+                    /* Set next interrupt state. */
+                    tune_state = FINE_TUNE;
+                }
+
+                break;
+#endif
+
             /* --------------- */
             /* FINE TUNE State */
             /* --------------- */
             case FINE_TUNE:
-#ifdef VCTCXO_DEBUG
-                puts("\nFINE_TUNE\n");
-#endif
-
                 /* We should be extremely close to a perfectly tuned VCTCXO, but
                    some minor adjustments need to be made. */
 
+#ifdef CONFIG_OUTLIER_WINDOW
+                /* Drop glitches (bad PPS edge, receiver time jump) before
+                   they reach the control law: no correction on this sample. */
+                if (!long_only &&
+                    outlier_filter_reject(&outlier_filter, vctcxo_tamer_pkt.pps_1s_error)) {
+                    break;
+                }
+#endif
+
+#ifdef CSR_LOCK_QUALITY_BASE
+                /* Lock quality of the error before the correction. */
+                lock_quality_update(&lock_quality, &vctcxo_tamer_pkt);
+#endif
+
+#ifdef FINE_TUNE_PI_LOOP
+                /* Run the PI loop on every 1s sample. */
+                pi_loop_update(&fine_tune_pi, vctcxo_tamer_pkt.pps_1s_error,
+                    vctcxo_tamer_pkt.pps_phase_error, trimdac_cal_line.slope);
+#elif defined(CONFIG_FINE_TUNE_ADAPTIVE)
+                /* Sum the 1s errors over a window chosen from the measured
+                   stability (1s up to 4^CONFIG_ADAPTIVE_MAX_LEVEL s). */
+                adaptive_update(&fine_tune_adaptive, vctcxo_tamer_pkt.pps_1s_error,
+                    trimdac_cal_line.slope);
+#else
+
                 /* Check the magnitude of the errors starting with the one
                    second count. If an error is greater than the maximum
                    tolerated error, adjust the trim DAC by the error
                    (Hz) multiplied by the slope (in counts/Hz) and scale the
-                   result by the precision interval (e.g. 1s, 10s, 100s). */
+                   result by the precision interval (e.g. 1s, 10s, 100s, long). */
 
                 if (vctcxo_tamer_pkt.pps_1s_error_flag)
                 {
-                    adjust_trim_dac(vctcxo_tamer_pkt.pps_1s_error, trimdac_cal_line.slope, 1);
+                    adjust_trim_dac(vctcxo_tamer_pkt.pps_1s_error, trimdac_cal_line.slope);
                 }
                 else if (vctcxo_tamer_pkt.pps_10s_error_flag)
                 {
-                    adjust_trim_dac(vctcxo_tamer_pkt.pps_10s_error, trimdac_cal_line.slope, 10);
+                    adjust_trim_dac(vctcxo_tamer_pkt.pps_10s_error, fine_tune_slopes.slope_10s);
                 }
                 else if (vctcxo_tamer_pkt.pps_100s_error_flag)
                 {
-                    adjust_trim_dac(vctcxo_tamer_pkt.pps_100s_error, trimdac_cal_line.slope, 100);
+                    adjust_trim_dac(vctcxo_tamer_pkt.pps_100s_error, fine_tune_slopes.slope_100s);
                 }
+                else if (vctcxo_tamer_pkt.pps_long_error_flag)
+                {
+                    adjust_trim_dac_div(vctcxo_tamer_pkt.pps_long_error, trimdac_cal_line.slope, vctcxo_tamer_long_len());
+                }
+#endif
+
+#ifdef CONFIG_HOLDOVER
+                /* Learn the drift model for HOLDOVER. */
+                holdover_learn(&holdover, read_trim_dac());
+#endif
+
+#ifdef CONFIG_TEMP_COMP
+                /* Learn the temperature compensation table. */
+                temp_comp_learn(&temp_comp, vctcxo_trim_dac_value);
+#endif
 
                 break;
 
@@ -274,12 +2113,47 @@ int main(void)
 
             }
 
+            /* Per-PPS telemetry frame (non-blocking). */
+            telemetry_send(&vctcxo_tamer_pkt, tune_state, pps_is_active());
+
+            /* Long window processed. */
+            vctcxo_tamer_pkt.pps_long_error_flag = false;
+
             /* Take PPS counters out of reset. */
             vctcxo_tamer_reset_counters(false);
 
             /* Enable interrupts. */
             vctcxo_tamer_enable_isr(true);
 
+            /* Per-state processing time, periodic report. */
+            prof_pps_done();
+            prof_record(prof_state, prof_start);
+#ifdef CSR_PROFILER_BASE
+            if (++prof_count >= PROF_REPORT_PERIOD) {
+                prof_count = 0;
+                prof_report();
+            }
+#endif
+        }
+
+        /* DAC ramping/settling: step it periodically (measurements restart
+           once settled). */
+        if (vctcxo_trim_dac_slew_busy()) {
+            delay_ms(CONFIG_DAC_SLEW_TICK_MS);
+            vctcxo_trim_dac_slew_tick();
+        }
+#ifdef CONFIG_HOLDOVER
+        /* HOLDOVER: no PPS events, apply the drift model periodically (once
+           per measurement interval, as learned). */
+        else if (tune_state == HOLDOVER) {
+            delay_ms(sample_interval_ms());
+            holdover_step(&holdover, trimdac_max);
+            telemetry_send(&vctcxo_tamer_pkt, tune_state, false);
+        }
+#endif
+        /* Sleep until the next PPS measurement or enable change. */
+        else {
+            wait_for_event();
         }
     }
 
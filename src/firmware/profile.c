@@ -0,0 +1,78 @@
+/*--------------------------------------------------------------------------
+-- FILE        : profile.c
+-- DESCRIPTION : Firmware cycle profiling file.
+-- DATE        :
+-- AUTHOR(s)   : Lime Microsystems.
+-- REVISIONS   :
+--------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <generated/soc.h>
+#include <generated/csr.h>
+
+#include "profile.h"
+
+#ifdef CSR_PROFILER_BASE
+
+/*-----------------------------------------------------------------------*/
+/* Global Variables                                                      */
+/*-----------------------------------------------------------------------*/
+
+/* Cycle count of the last PPS interrupt, until the DAC update it leads to. */
+static uint32_t prof_pps_cycles;
+static bool     prof_pps_pending;
+
+/*-----------------------------------------------------------------------*/
+/* Functions                                                             */
+/*-----------------------------------------------------------------------*/
+
+/* Records the cycles elapsed since start in a slot (the profiler keeps the
+   last/min/max values and the number of samples). */
+__attribute__((section(".text.isr")))
+void prof_record(uint8_t slot, uint32_t start) {
+    uint32_t cycles = prof_cycles() - start;
+
+    profiler_slot_write(slot);
+    profiler_sample_write(cycles);
+}
+
+/* Marks the reception of a PPS measurement (interrupt entry). */
+__attribute__((section(".text.isr")))
+void prof_pps_mark(void) {
+    prof_pps_cycles  = prof_cycles();
+    prof_pps_pending = true;
+}
+
+/* Ends the PPS measurement processing (no DAC update for it). */
+void prof_pps_done(void) {
+    prof_pps_pending = false;
+}
+
+/* Marks a trim DAC update, recording the latency from the PPS interrupt. */
+void prof_dac_mark(void) {
+    if (prof_pps_pending) {
+        prof_record(PROF_SLOT_LATENCY, prof_pps_cycles);
+        prof_pps_pending = false;
+    }
+}
+
+/* Prints the profiling slots on the UART. */
+void prof_report(void) {
+    printf("\nPROF @%luHz slot: last min max count\n", (unsigned long)CONFIG_CLOCK_FREQUENCY);
+    for (uint8_t slot = 0; slot < PROF_SLOTS; slot++) {
+        profiler_rd_slot_write(slot);
+        if (profiler_rd_count_read() == 0) {
+            continue;
+        }
+        printf("PROF %2u: %lu %lu %lu %lu\n", slot,
+            (unsigned long)profiler_rd_last_read(),
+            (unsigned long)profiler_rd_min_read(),
+            (unsigned long)profiler_rd_max_read(),
+            (unsigned long)profiler_rd_count_read());
+    }
+}
+
+#endif
@@ -0,0 +1,61 @@
+/*--------------------------------------------------------------------------
+-- FILE        : profile.h
+-- DESCRIPTION : Firmware cycle profiling header file.
+-- DATE        :
+-- AUTHOR(s)   : Lime Microsystems.
+-- REVISIONS   :
+--------------------------------------------------------------------------*/
+
+#ifndef PROFILE_H_
+#define PROFILE_H_
+
+#include <stdint.h>
+
+#include <generated/csr.h>
+
+/*-----------------------------------------------------------------------*/
+/* Profiling Slots                                                       */
+/*-----------------------------------------------------------------------*/
+
+/* Slots 0-7: FSM states (state_t) processing of a PPS measurement. */
+#define PROF_SLOT_ISR        8  /* CPU interrupt handler.                */
+#define PROF_SLOT_LATENCY    9  /* PPS interrupt to trim DAC update.     */
+#define PROF_SLOT_DELAY_MS  10  /* delay_ms(1).                          */
+#define PROF_SLOTS          11
+
+/* Number of processed PPS measurements between two UART reports. */
+#define PROF_REPORT_PERIOD  64
+
+/*-----------------------------------------------------------------------*/
+/* Function Prototypes                                                   */
+/*-----------------------------------------------------------------------*/
+
+#ifdef CSR_PROFILER_BASE
+
+/* Returns the free-running cycle counter. */
+static inline uint32_t prof_cycles(void) {
+    return cycle_counter_value_read();
+}
+
+void prof_record(uint8_t slot, uint32_t start);
+
+void prof_pps_mark(void);
+
+void prof_pps_done(void);
+
+void prof_dac_mark(void);
+
+void prof_report(void);
+
+#else
+
+static inline uint32_t prof_cycles(void) { return 0; }
+static inline void prof_record(uint8_t slot, uint32_t start) { (void)slot; (void)start; }
+static inline void prof_pps_mark(void) {}
+static inline void prof_pps_done(void) {}
+static inline void prof_dac_mark(void) {}
+static inline void prof_report(void) {}
+
+#endif
+
+#endif /* PROFILE_H_ */
@@ -0,0 +1,177 @@
+#!/usr/bin/env python3
+
+#
+# This file is part of LimePSB_RPCM_GW.
+#
+# Copyright (c) 2024-2025 Lime Microsystems.
+# SPDX-License-Identifier: Apache-2.0
+#
+# PPSDO firmware convergence benchmark: runs the host simulation of a set of firmware configurations
+# over synthetic scenarios and replayed recorded traces (gpsdo_monitor.py --export), and reports the
+# time to FINE_TUNE, time to the highest accuracy, steady-state RMS error, DAC step count and host
+# CPU time per main loop iteration as JSON. Fails on regressions against a baseline report.
+#
+
+import os
+import re
+import sys
+import json
+import argparse
+import tempfile
+import subprocess
+
+# Constants ----------------------------------------------------------------------------------------
+
+SIM_DIR = os.path.dirname(os.path.abspath(__file__))
+
+# Firmware configurations (SIM_CFLAGS, see Makefile). Without SIM_* peripheral flags the mock CSRs
+# match the generator defaults (optional peripherals off), "pi-all" adds all the optional ones.
+CONFIGS = {
+    "default"             : "",
+    "continuous"          : "-DSIM_CONTINUOUS",
+    "pi"                  : "-DSIM_CONTINUOUS -DCONFIG_FINE_TUNE_PI -DCONFIG_FIXED_POINT",
+    "dither"              : "-DSIM_CONTINUOUS -DCONFIG_FINE_TUNE_PI -DCONFIG_FIXED_POINT -DSIM_DAC_DITHER",
+    "continuous-phase"    : "-DSIM_CONTINUOUS -DCONFIG_FINE_TUNE_PHASE -DCONFIG_FIXED_POINT",
+    "continuous-adaptive" : "-DSIM_CONTINUOUS -DCONFIG_FINE_TUNE_ADAPTIVE -DCONFIG_FIXED_POINT",
+    "pi-all"              : "-DSIM_CONTINUOUS -DCONFIG_FINE_TUNE_PI -DCONFIG_FIXED_POINT -DSIM_SNAPSHOT "
+                            "-DSIM_CALIBRATION -DSIM_HISTORY -DSIM_LONG_LEN=1000 -DSIM_OUTLIER_WINDOW=5 "
+                            "-DCONFIG_HOLDOVER",
+}
+
+# Synthetic scenarios (simulation options).
+SCENARIOS = {
+    "nominal"     : [],
+    "gps-dropout" : ["-h", "1800,600"],
+    "temp-ramp"   : ["-T", "10,14400,20"],  # 0 to 10 C over the first hour.
+    "jitter"      : ["-j", "100"],
+}
+
+# Regressions (metric higher than the baseline): metric, relative and absolute tolerances. Lock times
+# and times to FINE_TUNE/highest accuracy of -1 (never reached) are regressions when the baseline
+# reached them. The host CPU time is reported only (host dependent).
+CHECKS = [
+    ("lock_time",     0.0,  0),
+    ("fine_time",     0.0,  0),
+    ("accuracy_time", 0.0,  0),
+    ("rms_ppb",       0.05, 0.1),
+    ("max_ppb",       0.10, 1.0),
+    ("dac_changes",   0.10, 2),
+]
+
+# Helpers ------------------------------------------------------------------------------------------
+
+def git_commit():
+    try:
+        return subprocess.run(["git", "rev-parse", "--short", "HEAD"], cwd=SIM_DIR, check=True,
+            capture_output=True, text=True).stdout.strip()
+    except (OSError, subprocess.CalledProcessError):
+        return None
+
+def build(name, cflags, build_dir):
+    """Build the simulation of a firmware configuration, returns its path."""
+    sim = os.path.join(build_dir, f"ppsdo_sim_{name}")
+    subprocess.run(["make", "-s", "-C", SIM_DIR, f"SIM={sim}", f"SIM_CFLAGS={cflags}"], check=True)
+    return sim
+
+def parse_summary(output):
+    """Parse the simulation key=value summary lines."""
+    metrics = {}
+    for key, value in re.findall(r"(\w+)=(-?[\d.]+)", output):
+        metrics[key] = float(value) if "." in value else int(value)
+    return metrics
+
+def trace_scenario(path):
+    """Replay scenario of a recorded trace (with its f0 from the export header)."""
+    args = ["-R", path]
+    with open(path) as f:
+        m = re.search(r"f0 (\d+) Hz", f.readline())
+    if m:
+        args += ["-f", m.group(1)]
+    return args
+
+def run(sim, args, seconds, seed):
+    cmd = [sim, "-c", "-s", str(seed)] + (["-n", str(seconds)] if seconds else []) + args
+    return parse_summary(subprocess.run(cmd, check=True, capture_output=True, text=True).stdout)
+
+# Comparison ---------------------------------------------------------------------------------------
+
+def compare(results, baseline):
+    """Compare results to a baseline report, returns the list of regressions (a configuration run
+    with other SIM_CFLAGS than in the baseline is skipped)."""
+    base = {(r["config"], r["scenario"]): r for r in baseline["results"]}
+    regressions = []
+    for r in results:
+        ref = base.get((r["config"], r["scenario"]))
+        if ref is None:
+            continue
+        if ref.get("cflags", r["cflags"]) != r["cflags"]:
+            print(f"Skipped: {r['config']}/{r['scenario']}: baseline SIM_CFLAGS \"{ref['cflags']}\"",
+                  file=sys.stderr)
+            continue
+        ref = ref["metrics"]
+        for metric, rel, abs_ in CHECKS:
+            if metric not in ref or metric not in r["metrics"]:
+                continue
+            old, new = ref[metric], r["metrics"][metric]
+            if metric.endswith("_time"):
+                worse = (old >= 0) and ((new < 0) or (new > old + abs_))
+            else:
+                worse = (new - old) > rel * abs(old) + abs_
+            if worse:
+                regressions.append(f"{r['config']}/{r['scenario']}: {metric} {old} -> {new}")
+    return regressions
+
+# Main ----------------------------------------------------------------------------------------------
+
+def main():
+    parser = argparse.ArgumentParser(description="PPSDO firmware convergence benchmark.")
+    parser.add_argument("traces",     nargs="*",                 help="Recorded replay traces (CSV, gpsdo_monitor.py --export).")
+    parser.add_argument("--config",   default=None, nargs="+",   help=f"Firmware configurations (default: all, {', '.join(CONFIGS)}).")
+    parser.add_argument("--scenario", default=None, nargs="+",   help=f"Synthetic scenarios (default: all, {', '.join(SCENARIOS)}).")
+    parser.add_argument("--seconds",  default=0,    type=int,    help="Simulated time (default: simulation default, trace length).")
+    parser.add_argument("--seed",     default=1,    type=int,    help="Noise generator seed (default: 1).")
+    parser.add_argument("--output",   default=None,              help="JSON report file (default: stdout).")
+    parser.add_argument("--baseline", default=None,              help="Baseline JSON report: fail on regressions.")
+    args = parser.parse_args()
+
+    configs   = args.config   or list(CONFIGS)
+    scenarios = {name: SCENARIOS[name] for name in (args.scenario or list(SCENARIOS))}
+    for path in args.traces:
+        scenarios[os.path.splitext(os.path.basename(path))[0]] = trace_scenario(path)
+
+    # Run.
+    results = []
+    with tempfile.TemporaryDirectory() as build_dir:
+        for config in configs:
+            print(f"{config}: SIM_CFLAGS=\"{CONFIGS[config]}\"", file=sys.stderr)
+            sim = build(config, CONFIGS[config], build_dir)
+            for scenario, scenario_args in scenarios.items():
+                metrics = run(sim, scenario_args, args.seconds, args.seed)
+                results.append({"config": config, "cflags": CONFIGS[config], "scenario": scenario,
+                    "metrics": metrics})
+                print(f"{config:20} {scenario:16} fine {metrics['fine_time']:5d}s "
+                      f"accuracy {metrics['accuracy_time']:5d}s rms {metrics['rms_ppb']:8.3f}ppb "
+                      f"dac steps {metrics['dac_changes']:5d} cpu {metrics['cpu_ns']:6.0f}ns",
+                      file=sys.stderr)
+
+    # Report.
+    report = {"commit": git_commit(), "seed": args.seed,
+        "configs": {config: CONFIGS[config] for config in configs}, "results": results}
+    if args.output:
+        with open(args.output, "w") as f:
+            json.dump(report, f, indent=1)
+    else:
+        json.dump(report, sys.stdout, indent=1)
+        print()
+
+    # Regressions.
+    if args.baseline:
+        with open(args.baseline) as f:
+            regressions = compare(results, json.load(f))
+        for regression in regressions:
+            print(f"Regression: {regression}", file=sys.stderr)
+        if regressions:
+            sys.exit(1)
+
+if __name__ == "__main__":
+    main()
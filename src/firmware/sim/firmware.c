@@ -0,0 +1,11 @@
+/*--------------------------------------------------------------------------
+-- FILE        : firmware.c
+-- DESCRIPTION : Host simulation firmware build: main.c with its main()
+--               renamed so that the simulator can run it.
+-- DATE        :
+-- AUTHOR(s)   : Lime Microsystems.
+-- REVISIONS   :
+--------------------------------------------------------------------------*/
+
+#define main firmware_main
+#include "../main.c"
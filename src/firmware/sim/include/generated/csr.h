@@ -0,0 +1,145 @@
+/*--------------------------------------------------------------------------
+-- FILE        : csr.h
+-- DESCRIPTION : Host simulation CSR accessors (replaces the LiteX
+--               generated header): PPSDO peripherals backed by the model.
+--               Optional peripherals are off unless their SIM_* flag is
+--               given (SIM_CFLAGS), as the generator defaults.
+-- DATE        :
+-- AUTHOR(s)   : Lime Microsystems.
+-- REVISIONS   :
+--------------------------------------------------------------------------*/
+
+#ifndef __GENERATED_CSR_H
+#define __GENERATED_CSR_H
+
+#include <stdint.h>
+
+#include "sim.h"
+
+/* VCTCXO Tamer enable/status (read once per main loop iteration: the model
+   advances by one PPS second). */
+static inline uint32_t vctcxo_tamer_status_read(void) { return sim_tamer_status(); }
+
+#ifdef SIM_SNAPSHOT
+/* VCTCXO Tamer snapshot (errors latched on the IRQ edge, counters kept
+   running). */
+#define CSR_VCTCXO_TAMER_SNAPSHOT_BASE 0
+static inline uint32_t vctcxo_tamer_snapshot_err_1s_read(void)   { return sim_snapshot_err(1); }
+static inline uint32_t vctcxo_tamer_snapshot_err_10s_read(void)  { return sim_snapshot_err(10); }
+static inline uint32_t vctcxo_tamer_snapshot_err_100s_read(void) { return sim_snapshot_err(100); }
+#endif
+
+#ifdef SIM_LONG_LEN
+/* VCTCXO Tamer long window (SIM_LONG_LEN seconds). */
+#define CSR_VCTCXO_TAMER_LONG_BASE 0
+static inline uint32_t vctcxo_tamer_long_len_read(void)        { return SIM_LONG_LEN; }
+static inline uint32_t vctcxo_tamer_long_target_read(void)     { return sim_target(SIM_LONG_LEN); }
+static inline uint32_t vctcxo_tamer_long_tol_read(void)        { return sim_long_tol(); }
+static inline uint32_t vctcxo_tamer_long_error_read(void)      { return sim_long_error(); }
+static inline uint32_t vctcxo_tamer_long_seq_read(void)        { return sim_long_seq(); }
+static inline void     vctcxo_tamer_long_restart_write(uint32_t v) { (void)v; sim_long_restart(); }
+#endif
+
+/* PPS detector. */
+#define CSR_PPS_STATUS_BASE 0
+static inline uint32_t pps_status_active_read(void) { return sim_pps_active(); }
+
+#ifdef SIM_CONTINUOUS
+/* PPS timestamps (continuous-count mode). */
+#define CSR_PPS_TIMESTAMP_BASE 0
+#define CSR_PPS_TIMESTAMP_EV_ENABLE_PPS_OFFSET 0
+static inline uint32_t pps_timestamp_timestamp_read(void)   { return sim_ts_timestamp(); }
+static inline uint32_t pps_timestamp_phase_read(void)       { return sim_ts_phase(); }
+static inline void     pps_timestamp_realign_write(uint32_t v) { (void)v; sim_ts_realign(); }
+static inline uint32_t pps_timestamp_target_1s_read(void)   { return sim_target(1); }
+static inline uint32_t pps_timestamp_tol_1s_read(void)      { return sim_tol(1); }
+static inline uint32_t pps_timestamp_target_10s_read(void)  { return sim_target(10); }
+static inline uint32_t pps_timestamp_tol_10s_read(void)     { return sim_tol(10); }
+static inline uint32_t pps_timestamp_target_100s_read(void) { return sim_target(100); }
+static inline uint32_t pps_timestamp_tol_100s_read(void)    { return sim_tol(100); }
+static inline uint32_t pps_timestamp_ev_pending_read(void)  { return sim_ts_pending(); }
+static inline void     pps_timestamp_ev_pending_write(uint32_t v) { if (v & 1) sim_ts_ack(); }
+static inline void     pps_timestamp_ev_enable_write(uint32_t v)  { (void)v; }
+#endif
+
+#ifdef SIM_LOCK_QUALITY
+/* Lock quality (continuous-count mode, lock threshold: 1s tolerance). */
+#define CSR_LOCK_QUALITY_BASE 0
+static inline void lock_quality_mean_1s_write(uint32_t v) { sim_lock_quality(SIM_LQ_MEAN_1S, v); }
+static inline void lock_quality_rms_1s_write(uint32_t v) { sim_lock_quality(SIM_LQ_RMS_1S, v); }
+static inline void lock_quality_max_1s_write(uint32_t v) { sim_lock_quality(SIM_LQ_MAX_1S, v); }
+static inline void lock_quality_mean_10s_write(uint32_t v) { sim_lock_quality(SIM_LQ_MEAN_10S, v); }
+static inline void lock_quality_rms_10s_write(uint32_t v) { sim_lock_quality(SIM_LQ_RMS_10S, v); }
+static inline void lock_quality_max_10s_write(uint32_t v) { sim_lock_quality(SIM_LQ_MAX_10S, v); }
+static inline void lock_quality_mean_100s_write(uint32_t v) { sim_lock_quality(SIM_LQ_MEAN_100S, v); }
+static inline void lock_quality_rms_100s_write(uint32_t v) { sim_lock_quality(SIM_LQ_RMS_100S, v); }
+static inline void lock_quality_max_100s_write(uint32_t v) { sim_lock_quality(SIM_LQ_MAX_100S, v); }
+static inline void lock_quality_locked_write(uint32_t v) { sim_lock_quality(SIM_LQ_LOCKED, v); }
+static inline void lock_quality_lock_time_write(uint32_t v) { sim_lock_quality(SIM_LQ_LOCK_TIME, v); }
+static inline uint32_t lock_quality_tol_read(void) { return 0; }
+#endif
+
+#ifdef SIM_PPS_INPUTS
+/* PPS Select (multiple PPS sources, continuous-count mode). */
+#define CSR_PPS_SELECT_BASE 0
+static inline void     pps_select_source_write(uint32_t v)    { sim_pps_select(v); }
+static inline uint32_t pps_select_active_read(void)           { return sim_pps_sources_active(); }
+static inline void     pps_select_rd_source_write(uint32_t v) { sim_pps_rd_source(v); }
+static inline uint32_t pps_select_rd_timestamp_read(void)     { return sim_pps_rd_timestamp(); }
+static inline uint32_t pps_select_rd_count_read(void)         { return sim_pps_rd_count(); }
+#endif
+
+#ifdef SIM_REF_RATE
+/* 10 MHz reference tick (selected: the model steps are reference ticks). */
+#define CSR_REF_TICK_BASE 0
+static inline uint32_t ref_tick_enable_read(void) { return 1; }
+static inline uint32_t ref_tick_active_read(void) { return 1; }
+#endif
+
+/* Temperature (used with CONFIG_TEMP_COMP). */
+#define CSR_TEMP_COMP_BASE 0
+static inline uint32_t temp_comp_temp_read(void)  { return (uint16_t)sim_temp(); }
+static inline uint32_t temp_comp_valid_read(void) { return 1; }
+
+#ifdef SIM_DAC_DITHER
+/* DAC dither (fractional trim DAC, averaged by the VCTCXO in the model). */
+#define CSR_DAC_DITHER_BASE 0
+static inline void dac_dither_frac_write(uint32_t v) { sim_dac_frac(v); }
+#endif
+
+#ifdef SIM_CONFIG_UPDATE
+/* Config Update (applied configuration generation and 1s target). */
+#define CSR_CONFIG_UPDATE_BASE 0
+static inline uint32_t config_update_gen_read(void)       { return sim_config_gen(); }
+static inline uint32_t config_update_target_1s_read(void) { return sim_target(1); }
+#endif
+
+#ifdef SIM_CALIBRATION
+/* Calibration (slope export, warm start with the sim --warm option). */
+#define CSR_CALIBRATION_BASE 0
+static inline uint32_t calibration_warm_start_read(void)  { return sim_cal_warm_start(); }
+static inline uint32_t calibration_warm_slope_read(void)  { return sim_cal_warm_slope(); }
+static inline uint32_t calibration_warm_dac_read(void)    { return sim_cal_warm_dac(); }
+static inline void     calibration_slope_write(uint32_t v) { sim_cal_slope(v); }
+#endif
+
+#ifdef SIM_OUTLIER_WINDOW
+/* Outlier Filter (rejected samples count). */
+#define CSR_OUTLIER_FILTER_BASE 0
+static inline void outlier_filter_rejected_write(uint32_t v) { sim_outlier_rejected(v); }
+#endif
+
+#ifdef SIM_HISTORY
+/* Error history (per-PPS samples pushed by the firmware). */
+#define CSR_HISTORY_BASE 0
+static inline void history_data0_write(uint32_t v) { sim_history_data(0, v); }
+static inline void history_data1_write(uint32_t v) { sim_history_data(1, v); }
+static inline void history_push_write(uint32_t v)  { (void)v; sim_history_push(); }
+#endif
+
+/* UART (telemetry frames, used with CONFIG_TELEMETRY). */
+#define CSR_UART_BASE 0
+static inline void     uart_rxtx_write(uint32_t v) { sim_uart_write(v); }
+static inline uint32_t uart_txempty_read(void)     { return 1; }
+
+#endif
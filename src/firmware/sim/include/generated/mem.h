@@ -0,0 +1,13 @@
+/*--------------------------------------------------------------------------
+-- FILE        : mem.h
+-- DESCRIPTION : Host simulation memory map (replaces the LiteX generated
+--               header, the VCTCXO Tamer is accessed through the model).
+-- DATE        :
+-- AUTHOR(s)   : Lime Microsystems.
+-- REVISIONS   :
+--------------------------------------------------------------------------*/
+
+#ifndef __GENERATED_MEM_H
+#define __GENERATED_MEM_H
+
+#endif
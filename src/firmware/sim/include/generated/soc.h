@@ -0,0 +1,47 @@
+/*--------------------------------------------------------------------------
+-- FILE        : soc.h
+-- DESCRIPTION : Host simulation SoC constants (replaces the LiteX
+--               generated header). Firmware CONFIG_* options are passed
+--               with SIM_CFLAGS (see Makefile).
+-- DATE        :
+-- AUTHOR(s)   : Lime Microsystems.
+-- REVISIONS   :
+--------------------------------------------------------------------------*/
+
+#ifndef __GENERATED_SOC_H
+#define __GENERATED_SOC_H
+
+#define CONFIG_SIM
+
+/* delay_ms() busy loop: one iteration per ms. */
+#define CONFIG_CLOCK_FREQUENCY 320000
+
+#define CONFIG_DAC_MIN 0
+#ifndef CONFIG_DAC_MAX
+#define CONFIG_DAC_MAX 65535
+#endif
+
+#ifdef SIM_PPS_INPUTS
+#define CONFIG_PPS_INPUTS SIM_PPS_INPUTS
+#endif
+
+#ifdef SIM_REF_RATE
+#define CONFIG_REF_RATE  SIM_REF_RATE
+#define CONFIG_REF_SHIFT ((SIM_REF_RATE >= 64) ? 6 : (SIM_REF_RATE >= 32) ? 5 : \
+                          (SIM_REF_RATE >= 16) ? 4 : (SIM_REF_RATE >= 8)  ? 3 : \
+                          (SIM_REF_RATE >= 4)  ? 2 : (SIM_REF_RATE >= 2)  ? 1 : 0)
+#endif
+
+/* Outlier filter (off by default, as the generator: --outlier-window=0). */
+#ifdef SIM_OUTLIER_WINDOW
+#define CONFIG_OUTLIER_WINDOW SIM_OUTLIER_WINDOW
+#ifndef CONFIG_OUTLIER_FLOOR
+#define CONFIG_OUTLIER_FLOOR 64
+#endif
+#endif
+
+#if defined(SIM_DAC_DITHER) && !defined(CONFIG_DAC_FRAC_BITS)
+#define CONFIG_DAC_FRAC_BITS 8
+#endif
+
+#endif
@@ -0,0 +1,18 @@
+/*--------------------------------------------------------------------------
+-- FILE        : irq.h
+-- DESCRIPTION : Host simulation CPU interrupt stubs (the simulated
+--               firmware polls the peripherals).
+-- DATE        :
+-- AUTHOR(s)   : Lime Microsystems.
+-- REVISIONS   :
+--------------------------------------------------------------------------*/
+
+#ifndef __IRQ_H
+#define __IRQ_H
+
+static inline void irq_setie(unsigned int ie) { (void)ie; }
+static inline unsigned int irq_getmask(void) { return 0; }
+static inline void irq_setmask(unsigned int mask) { (void)mask; }
+static inline unsigned int irq_pending(void) { return 0; }
+
+#endif
@@ -0,0 +1,1089 @@
+/*--------------------------------------------------------------------------
+-- FILE        : sim.c
+-- DESCRIPTION : Host simulation of the PPSDO: runs the unmodified firmware
+--               (main.c, vctcxo_tamer.c) against register-level models of
+--               the VCTCXO Tamer and PPS timestamps, a simulated VCTCXO and
+--               a PPS source, one main loop iteration per PPS second.
+-- DATE        :
+-- AUTHOR(s)   : Lime Microsystems.
+-- REVISIONS   :
+--------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <getopt.h>
+#include <setjmp.h>
+#include <math.h>
+#include <time.h>
+
+#include "sim.h"
+#include "vctcxo_tamer.h"
+
+/*-----------------------------------------------------------------------*/
+/* Constants                                                             */
+/*-----------------------------------------------------------------------*/
+
+#define SIM_DAC_MID   0x8000
+
+/* PPS sources: fixed offset between consecutive sources (ns). */
+#define SIM_PPS_SOURCES_MAX   4
+#define SIM_PPS_SOURCE_OFFSET 50.0
+
+/* Lock: frequency error within the lock threshold for this long (s). */
+#define SIM_LOCK_HOLD 60
+
+/* Accuracy: highest level, the 1s, 10s and 100s errors within tolerance. */
+#define SIM_ACCURACY_MAX 3
+
+/* Long window tolerance (ppb, as the host default: --long-ppb=1.0). */
+#define SIM_LONG_PPB 1.0
+
+/* Model steps per second: one per PPS, or per reference tick with the
+   10 MHz reference (SIM_REF_RATE ticks per second). */
+#ifdef SIM_REF_RATE
+#define SIM_TICKS SIM_REF_RATE
+#else
+#define SIM_TICKS 1
+#endif
+
+/*-----------------------------------------------------------------------*/
+/* Types                                                                 */
+/*-----------------------------------------------------------------------*/
+
+/* Replayed trace, one record per second (NAN: field not recorded, taken
+   from the model). */
+typedef struct sim_replay {
+    uint32_t n;
+    bool    *pps;           /* PPS present.                                    */
+    double  *ppb;           /* VCTCXO frequency error at mid-scale DAC (ppb).  */
+    double  *pps_ns;        /* PPS time error (ns).                            */
+    double  *temp;          /* Board temperature (C).                          */
+} sim_replay_t;
+
+/* Simulation parameters. */
+typedef struct sim_config {
+    uint32_t seconds;       /* Simulated time (s).                             */
+    uint64_t seed;          /* Noise generator seed.                           */
+    double   f0;            /* RF clock (VCTCXO) nominal frequency (Hz).         */
+    double   tol_ppm;       /* Tamer tolerance (ppm, same for all windows).    */
+    double   offset_ppb;    /* VCTCXO frequency offset at mid-scale DAC.       */
+    double   slope_ppb;     /* VCTCXO tuning slope (ppb/DAC count).            */
+    double   white_ppb;     /* White frequency noise (ppb rms, 1s).            */
+    double   walk_ppb;      /* Random walk frequency noise (ppb/sqrt(s)).      */
+    double   drift_ppb;     /* Aging (ppb/hour).                               */
+    double   temp_amp;      /* Temperature swing amplitude (C).                */
+    double   temp_period;   /* Temperature swing period (s).                   */
+    double   temp_coef_ppb; /* VCTCXO temperature coefficient (ppb/C).         */
+    double   jitter_ns;     /* PPS jitter (ns rms).                            */
+    uint32_t enable_at;     /* Tamer enable time (s).                          */
+    uint32_t outage_start;  /* PPS outage start time (s, 0: no outage).        */
+    uint32_t outage_len;    /* PPS outage length (s).                          */
+    double   lock_ppb;      /* Lock threshold (ppb, default: tolerance).       */
+    uint32_t bad_start;     /* PPS source 0 degraded from this time (s, 0: no).  */
+    double   bad_jitter_ns; /* PPS source 0 jitter once degraded (0: lost).    */
+    uint32_t clk_at;        /* RF clock change time (s, 0: no change).         */
+    double   clk_f0;        /* RF clock nominal frequency after the change.    */
+    bool     cpu;           /* Report the firmware host CPU time.              */
+    bool     warm;          /* Warm start from the model calibration.          */
+    sim_replay_t replay;    /* Replayed trace (n = 0: noise models only).      */
+    FILE    *trace;         /* Per-second trace (CSV), optional.               */
+    FILE    *telemetry;     /* Firmware UART output, optional.                 */
+} sim_config_t;
+
+/* Simulation state. */
+typedef struct sim {
+    uint32_t t;             /* Current time (steps, 1/SIM_TICKS s).            */
+    uint64_t rng;
+    double   phase;         /* VCTCXO phase (RF clock cycles).                 */
+    double   walk;          /* Random walk frequency state (ppb).              */
+    double   y;             /* Last second VCTCXO frequency error (ppb).       */
+    double   f0;            /* RF clock nominal frequency (Hz).                */
+
+    /* Configuration (targets/tolerances of f0_cfg, SIM_CONFIG_UPDATE: applied
+       at the first PPS after a config_gen change). */
+    double   f0_cfg;
+    uint8_t  gen;
+    uint8_t  gen_host;
+
+    /* VCTCXO Tamer registers. */
+    uint8_t  ctrl;
+    uint8_t  stat;
+    uint8_t  state;
+    uint8_t  dac[2];
+    uint32_t dac_frac;      /* DAC dither fractional part (1/2^N counts).      */
+    int32_t  err_1s;
+    int32_t  err_10s;
+    int32_t  err_100s;
+
+    /* VCTCXO Tamer snapshot (errors latched on the last IRQ edge). */
+    int32_t  snap_1s;
+    int32_t  snap_10s;
+    int32_t  snap_100s;
+
+    /* VCTCXO Tamer long window. */
+    bool     long_valid;
+    bool     long_restart;
+    uint32_t long_seconds;
+    int64_t  long_start;
+    int32_t  long_error;
+    uint32_t long_seq;
+
+    /* VCTCXO Tamer counters. */
+    bool     running;
+    uint32_t count;         /* Seconds since the counters start.               */
+    int64_t  start_1s;
+    int64_t  start_10s;
+    int64_t  start_100s;
+
+    /* PPS timestamps. */
+    int64_t  ts;
+    int64_t  epoch;         /* Local 1s epoch origin.                          */
+    bool     realign;
+    bool     ts_pending;
+    int32_t  ts_phase;
+
+    /* Metrics. */
+    uint32_t dac_changes;
+    uint16_t dac_last;
+    bool     locked;
+    uint32_t lock_count;    /* Seconds within the lock threshold.              */
+    uint32_t lock_time;     /* Lock time, from enable (s).                     */
+    uint32_t unlocks;       /* Excursions over the lock threshold after lock.  */
+    bool     over;
+    double   sum2;          /* Frequency error after lock (ppb^2).             */
+    double   max;
+    uint32_t n;
+    double   holdover_max;  /* Frequency error during the PPS outage (ppb).    */
+    int32_t  fine_time;     /* First FINE_TUNE state, from enable (s, -1).     */
+    int32_t  accuracy_time; /* First highest accuracy, from enable (s, -1).    */
+    uint8_t  accuracy;      /* Accuracy level (0-SIM_ACCURACY_MAX).            */
+    int64_t  acc_ts[101];   /* PPS timestamps at the last 100 seconds.         */
+    uint32_t acc_n;         /* Consecutive seconds in FINE_TUNE with a PPS.    */
+
+    /* Firmware host CPU time per main loop iteration (ns). */
+    struct timespec cpu_end;
+    double   cpu_sum;
+    double   cpu_max;
+    uint32_t cpu_n;
+
+    /* PPS sources (source 0 without SIM_PPS_INPUTS). */
+    uint32_t pps_sel;
+    uint32_t pps_rd;
+    uint32_t pps_switches;
+    uint32_t src_active;
+    uint32_t src_ts[SIM_PPS_SOURCES_MAX];
+    uint8_t  src_count[SIM_PPS_SOURCES_MAX];
+
+    /* Firmware lock quality outputs. */
+    uint32_t lq[SIM_LQ_COUNT];
+
+    /* Firmware calibration, outlier filter and history outputs. */
+    uint32_t cal_slope;
+    uint32_t rejected;
+    uint32_t history[2];
+    uint32_t history_seq;
+} sim_t;
+
+/*-----------------------------------------------------------------------*/
+/* Global Variables                                                      */
+/*-----------------------------------------------------------------------*/
+
+static sim_config_t cfg = {
+    .seconds       = 3600,
+    .seed          = 1,
+    .f0            = 30.72e6,
+    .tol_ppm       = 0.1,
+    .offset_ppb    = 1500.0,
+    .slope_ppb     = 10000.0 / 65536.0,
+    .white_ppb     = 0.1,
+    .walk_ppb      = 0.01,
+    .drift_ppb     = 0.0,
+    .temp_amp      = 0.0,
+    .temp_period   = 3600.0,
+    .temp_coef_ppb = 20.0,
+    .jitter_ns     = 20.0,
+    .enable_at     = 1,
+    .outage_start  = 0,
+    .outage_len    = 0,
+    .lock_ppb      = 0.0,
+    .trace         = NULL,
+    .telemetry     = NULL,
+};
+
+static sim_t   sim;
+static jmp_buf sim_end;
+
+/*-----------------------------------------------------------------------*/
+/* Helpers                                                               */
+/*-----------------------------------------------------------------------*/
+
+/* Returns a uniform random number in [0, 1) (splitmix64). */
+static double sim_uniform(void)
+{
+    uint64_t z = (sim.rng += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    z =  z ^ (z >> 31);
+    return (double)(z >> 11) / (double)(1ull << 53);
+}
+
+/* Returns a normal random number (Box-Muller). */
+static double sim_gauss(void)
+{
+    double u = sim_uniform();
+    double v = sim_uniform();
+    return sqrt(-2.0 * log(1.0 - u)) * cos(2.0 * M_PI * v);
+}
+
+/* Returns the replayed trace record index for time t (s), -1 without. */
+static int32_t sim_replay_index(uint32_t t)
+{
+    if (cfg.replay.n == 0) {
+        return -1;
+    }
+    return (t < cfg.replay.n) ? (int32_t)t : (int32_t)cfg.replay.n - 1;
+}
+
+/* Returns true when the PPS is present at time t. */
+static bool sim_pps_present(uint32_t t)
+{
+    int32_t i = sim_replay_index(t);
+
+    if ((i >= 0) && !cfg.replay.pps[i]) {
+        return false;
+    }
+    return (cfg.outage_len == 0) || (t < cfg.outage_start) ||
+           (t >= cfg.outage_start + cfg.outage_len);
+}
+
+/* Returns the board temperature (C). */
+static double sim_temperature(double t)
+{
+    int32_t i = sim_replay_index((uint32_t)t);
+
+    if ((i >= 0) && !isnan(cfg.replay.temp[i])) {
+        return cfg.replay.temp[i];
+    }
+    return 25.0 + cfg.temp_amp * sin(2.0 * M_PI * t / cfg.temp_period);
+}
+
+/* Returns the PPS time error (ns) of an edge at time t (s). */
+static double sim_pps_error(uint32_t t, double jitter_ns)
+{
+    int32_t i = sim_replay_index(t);
+
+    if ((i >= 0) && !isnan(cfg.replay.pps_ns[i])) {
+        return cfg.replay.pps_ns[i];
+    }
+    return jitter_ns * sim_gauss();
+}
+
+/* Returns the trim DAC value from the Tamer registers. */
+static uint16_t sim_dac(void)
+{
+    return (uint16_t)(sim.dac[0] | (sim.dac[1] << 8));
+}
+
+/* Returns the average DAC output (with the DAC dither fractional part). */
+static double sim_dac_avg(void)
+{
+#ifdef CONFIG_DAC_FRAC_BITS
+    return sim_dac() + (double)sim.dac_frac / (1 << CONFIG_DAC_FRAC_BITS);
+#else
+    return sim_dac();
+#endif
+}
+
+/* VCTCXO Tamer counters on a PPS edge (1s/10s/100s windows). */
+static void sim_tamer_pps(int64_t ts)
+{
+    uint8_t mode = sim.ctrl & VT_CTRL_TUNE_MODE;
+    uint8_t stat = sim.stat;
+
+    if ((mode == 0) || (sim.ctrl & VT_CTRL_RESET)) {
+        sim.running = false;
+        return;
+    }
+
+    /* First PPS after reset: start of all windows. */
+    if (!sim.running) {
+        sim.running    = true;
+        sim.count      = 0;
+        sim.start_1s   = ts;
+        sim.start_10s  = ts;
+        sim.start_100s = ts;
+        return;
+    }
+
+    sim.count++;
+    sim.err_1s   = (int32_t)(ts - sim.start_1s - sim_target(1));
+    sim.start_1s = ts;
+    if (labs(sim.err_1s) > (long)sim_tol(1)) {
+        sim.stat |= VT_STAT_ERR_1S;
+    }
+    if ((sim.count % 10) == 0) {
+        sim.err_10s   = (int32_t)(ts - sim.start_10s - sim_target(10));
+        sim.start_10s = ts;
+        if (labs(sim.err_10s) > (long)sim_tol(10)) {
+            sim.stat |= VT_STAT_ERR_10S;
+        }
+    }
+    if ((sim.count % 100) == 0) {
+        sim.err_100s   = (int32_t)(ts - sim.start_100s - sim_target(100));
+        sim.start_100s = ts;
+        if (labs(sim.err_100s) > (long)sim_tol(100)) {
+            sim.stat |= VT_STAT_ERR_100S;
+        }
+    }
+
+    /* IRQ edge: snapshot of the errors. */
+    if ((stat == 0) && (sim.stat != 0)) {
+        sim.snap_1s   = sim.err_1s;
+        sim.snap_10s  = sim.err_10s;
+        sim.snap_100s = sim.err_100s;
+    }
+}
+
+#ifdef SIM_LONG_LEN
+/* Long window on a PPS edge (SIM_LONG_LEN periods, back to back). */
+static void sim_long_pps(int64_t ts)
+{
+    uint32_t seconds = sim.long_seconds++;
+
+    if (sim.long_restart || !sim.long_valid) {
+        sim.long_start   = ts;
+        sim.long_seconds = 1;
+        sim.long_valid   = true;
+        sim.long_restart = false;
+    } else if (seconds >= SIM_LONG_LEN) {
+        sim.long_error   = (int32_t)(ts - sim.long_start - sim_target(SIM_LONG_LEN));
+        sim.long_start   = ts;
+        sim.long_seconds = 1;
+        sim.long_seq++;
+    }
+}
+#endif
+
+/* PPS timestamps on a PPS edge (free-running counter, local 1s epoch). */
+static void sim_timestamp_pps(int64_t ts)
+{
+    int64_t target = sim_target(1);
+    int64_t phase;
+
+    sim.ts         = ts;
+    sim.ts_pending = true;
+    if (sim.realign) {
+        sim.realign = false;
+        sim.epoch   = ts;
+    }
+    phase = (ts - sim.epoch) % target;
+    if (phase < 0) {
+        phase += target;
+    }
+    if (phase >= target / 2) {
+        phase -= target;
+    }
+    sim.ts_phase = (int32_t)phase;
+}
+
+/* Updates the accuracy level, modelled on the Tamer accuracy status: the
+   number of consecutive 1s, 10s and 100s errors within the tolerance, from
+   the PPS timestamps taken at each second in FINE_TUNE. */
+static void sim_accuracy(bool enabled)
+{
+    static const uint32_t windows[SIM_ACCURACY_MAX] = {1, 10, 100};
+    uint32_t t = sim.t / SIM_TICKS;
+
+    if ((sim.t % SIM_TICKS) != 0) {
+        return;
+    }
+    sim.accuracy = 0;
+    if (!enabled || (sim.state != 0x01) || !sim_pps_active()) {
+        sim.acc_n = 0;
+        return;
+    }
+    sim.acc_ts[t % 101] = sim.ts;
+    sim.acc_n++;
+    for (int i = 0; (i < SIM_ACCURACY_MAX) && (sim.acc_n > windows[i]); i++) {
+        int64_t error = sim.ts - sim.acc_ts[(t - windows[i]) % 101] - llround(windows[i] * sim.f0_cfg);
+
+        if (llabs(error) > llround(windows[i] * sim.f0_cfg * cfg.tol_ppm * 1e-6)) {
+            break;
+        }
+        sim.accuracy = i + 1;
+    }
+
+    /* Time to highest accuracy: first time reached, from enable. */
+    if ((sim.accuracy == SIM_ACCURACY_MAX) && (sim.accuracy_time < 0)) {
+        sim.accuracy_time = (int32_t)(t - cfg.enable_at);
+    }
+}
+
+/* Updates the metrics with the last second frequency error. */
+static void sim_metrics(bool enabled)
+{
+    double lock   = (cfg.lock_ppb > 0.0) ? cfg.lock_ppb : cfg.tol_ppm * 1000.0;
+    double y_abs  = fabs(sim.y);
+    bool   outage = !sim_pps_present(sim.t / SIM_TICKS);
+    uint16_t dac  = sim_dac();
+
+    if (dac != sim.dac_last) {
+        sim.dac_last = dac;
+        sim.dac_changes++;
+    }
+
+    sim_accuracy(enabled);
+    if (!enabled) {
+        return;
+    }
+
+    /* Time to fine tune: first FINE_TUNE state, from enable. */
+    if ((sim.state == 0x01) && (sim.fine_time < 0)) {
+        sim.fine_time = (int32_t)(sim.t / SIM_TICKS - cfg.enable_at);
+    }
+
+    if (outage) {
+        if (y_abs > sim.holdover_max) {
+            sim.holdover_max = y_abs;
+        }
+        return;
+    }
+
+    /* Time to lock: first time the error stays within the threshold. */
+    if (!sim.locked) {
+        sim.lock_count = (y_abs > lock) ? 0 : sim.lock_count + 1;
+        if (sim.lock_count < SIM_LOCK_HOLD * SIM_TICKS) {
+            return;
+        }
+        sim.locked    = true;
+        sim.lock_time = (sim.t - SIM_LOCK_HOLD * SIM_TICKS + 1) / SIM_TICKS - cfg.enable_at;
+    }
+
+    /* After lock: excursions and frequency error statistics. */
+    if ((y_abs > lock) && !sim.over) {
+        sim.unlocks++;
+    }
+    sim.over  = y_abs > lock;
+    sim.sum2 += sim.y * sim.y;
+    sim.n++;
+    if (y_abs > sim.max) {
+        sim.max = y_abs;
+    }
+}
+
+/* Applies the configuration at a PPS edge (SIM_CONFIG_UPDATE: once the host
+   changed config_gen, the accuracy history restarts). */
+static void sim_config_pps(void)
+{
+    if (sim.gen != sim.gen_host) {
+        sim.gen    = sim.gen_host;
+        sim.f0_cfg = sim.f0;
+        sim.acc_n  = 0;
+    }
+}
+
+/* Advances the simulation by one step (PPS or reference tick edge at the
+   end). */
+static void sim_step(void)
+{
+    bool    enabled = sim.t >= cfg.enable_at * SIM_TICKS;
+    int32_t replay;
+
+    if (sim.t >= cfg.seconds * SIM_TICKS) {
+        longjmp(sim_end, 1);
+    }
+    sim.t++;
+
+    /* RF clock change: the host updates the configuration with it (new
+       config_gen), applied at once without SIM_CONFIG_UPDATE (live CSRs). */
+    if ((cfg.clk_at != 0) && (sim.t == cfg.clk_at * SIM_TICKS)) {
+        sim.f0 = cfg.clk_f0;
+        sim.gen_host++;
+#ifndef SIM_CONFIG_UPDATE
+        sim_config_pps();
+#endif
+    }
+
+    /* VCTCXO frequency error over the last step (white noise averaged over
+       1/SIM_TICKS s, random walk per sqrt(s)), or the replayed trace one:
+       the recorded free-running frequency error then replaces the offset,
+       aging, temperature and noise models. */
+    replay    = sim_replay_index(sim.t / SIM_TICKS);
+    sim.walk += cfg.walk_ppb / sqrt(SIM_TICKS) * sim_gauss();
+    if ((replay >= 0) && !isnan(cfg.replay.ppb[replay])) {
+        sim.y = cfg.replay.ppb[replay] + cfg.slope_ppb * (sim_dac_avg() - SIM_DAC_MID);
+    } else {
+        sim.y = cfg.offset_ppb +
+                cfg.slope_ppb * (sim_dac_avg() - SIM_DAC_MID) +
+                cfg.drift_ppb * sim.t / (3600.0 * SIM_TICKS) +
+                cfg.temp_coef_ppb * (sim_temperature((double)sim.t / SIM_TICKS) - 25.0) +
+                sim.walk +
+                cfg.white_ppb * sqrt(SIM_TICKS) * sim_gauss();
+    }
+    sim.phase += sim.f0 * (1.0 + sim.y * 1e-9) / SIM_TICKS;
+
+    /* PPS edge: RF clock count at the (jittered) PPS. */
+#ifdef SIM_PPS_INPUTS
+    /* Sources at a fixed offset from each other, each with its own jitter
+       (source 0 degraded or lost from bad_start), the selected one drives
+       the Tamer and the PPS timestamps. */
+    sim.src_active = 0;
+    if (sim_pps_present(sim.t / SIM_TICKS)) {
+        for (int i = 0; i < SIM_PPS_INPUTS; i++) {
+            double  jitter = cfg.jitter_ns;
+            int64_t ts;
+
+            if ((i == 0) && (cfg.bad_start != 0) && (sim.t >= cfg.bad_start * SIM_TICKS)) {
+                if (cfg.bad_jitter_ns == 0.0) {
+                    continue;
+                }
+                jitter = cfg.bad_jitter_ns;
+            }
+            ts = (int64_t)floor(sim.phase + (i * SIM_PPS_SOURCE_OFFSET + sim_pps_error(sim.t / SIM_TICKS, jitter)) * 1e-9 * sim.f0);
+            sim.src_active   |= 1u << i;
+            sim.src_ts[i]     = (uint32_t)ts;
+            sim.src_count[i] += 1;
+            if ((uint32_t)i == sim.pps_sel) {
+                sim_tamer_pps(ts);
+                sim_timestamp_pps(ts);
+#ifdef SIM_LONG_LEN
+                sim_long_pps(ts);
+#endif
+            }
+        }
+        sim_config_pps();
+    }
+#else
+    if (sim_pps_present(sim.t / SIM_TICKS)) {
+        int64_t ts = (int64_t)floor(sim.phase + sim_pps_error(sim.t / SIM_TICKS, cfg.jitter_ns) * 1e-9 * sim.f0);
+        sim_tamer_pps(ts);
+        sim_timestamp_pps(ts);
+#ifdef SIM_LONG_LEN
+        sim_long_pps(ts);
+#endif
+        sim_config_pps();
+    }
+#endif
+
+    sim_metrics(enabled);
+
+    if (cfg.trace) {
+        fprintf(cfg.trace, "%u,%u,%u,%.3f,%d,%d\n", sim.t, sim_dac(), sim.state, sim.y,
+            sim_pps_present(sim.t / SIM_TICKS) ? 1 : 0, sim.err_1s);
+    }
+}
+
+/*-----------------------------------------------------------------------*/
+/* VCTCXO Tamer Registers                                                */
+/*-----------------------------------------------------------------------*/
+
+/* Reads a byte from VCTCXO Tamer register. */
+uint8_t vctcxo_tamer_read(uint8_t addr) {
+    uint32_t value;
+
+    switch (addr & ~0x3) {
+    case VT_ERR_1S_ADDR:   value = (uint32_t)sim.err_1s;   break;
+    case VT_ERR_10S_ADDR:  value = (uint32_t)sim.err_10s;  break;
+    case VT_ERR_100S_ADDR: value = (uint32_t)sim.err_100s; break;
+    default:
+        switch (addr) {
+        case VT_CTRL_ADDR:            return sim.ctrl;
+        case VT_STAT_ADDR:            return sim.stat;
+        case VT_STATE_ADDR:           return sim.state;
+        case VT_DAC_TUNNED_VAL_ADDR0: return sim.dac[0];
+        case VT_DAC_TUNNED_VAL_ADDR1: return sim.dac[1];
+        default:                      return 0;
+        }
+    }
+    return (uint8_t)(value >> (8 * (addr & 0x3)));
+}
+
+/* Writes a byte to VCTCXO Tamer register. */
+void vctcxo_tamer_write(uint8_t addr, uint8_t data) {
+    switch (addr) {
+    case VT_CTRL_ADDR:
+        if (data & VT_CTRL_IRQ_CLR) {
+            sim.stat = 0;
+        }
+        if (data & VT_CTRL_RESET) {
+            sim.running = false;
+        }
+        sim.ctrl = data & ~VT_CTRL_IRQ_CLR;
+        break;
+    case VT_STATE_ADDR:           sim.state  = data; break;
+    case VT_DAC_TUNNED_VAL_ADDR0: sim.dac[0] = data; break;
+    case VT_DAC_TUNNED_VAL_ADDR1: sim.dac[1] = data; break;
+    default:                      break;
+    }
+}
+
+/*-----------------------------------------------------------------------*/
+/* CSRs                                                                  */
+/*-----------------------------------------------------------------------*/
+
+/* Accounts the firmware host CPU time since the end of the last model step
+   (the main loop iteration processing it), once enabled. */
+static void sim_cpu(void)
+{
+    struct timespec now;
+    double          ns;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if (sim.t > cfg.enable_at * SIM_TICKS) {
+        ns = (now.tv_sec - sim.cpu_end.tv_sec) * 1e9 + (now.tv_nsec - sim.cpu_end.tv_nsec);
+        sim.cpu_sum += ns;
+        sim.cpu_n++;
+        if (ns > sim.cpu_max) {
+            sim.cpu_max = ns;
+        }
+    }
+}
+
+uint32_t sim_tamer_status(void)
+{
+    if (cfg.cpu) {
+        sim_cpu();
+    }
+    sim_step();
+    if (cfg.cpu) {
+        clock_gettime(CLOCK_MONOTONIC, &sim.cpu_end);
+    }
+    return (sim.t >= cfg.enable_at * SIM_TICKS) ? 1 : 0;
+}
+
+uint32_t sim_pps_active(void)
+{
+#ifdef SIM_PPS_INPUTS
+    return (sim.src_active >> sim.pps_sel) & 1;
+#else
+    return sim_pps_present(sim.t / SIM_TICKS) ? 1 : 0;
+#endif
+}
+
+uint32_t sim_target(uint32_t seconds)
+{
+    return (uint32_t)llround(seconds * sim.f0_cfg / SIM_TICKS);
+}
+
+uint32_t sim_tol(uint32_t seconds)
+{
+    return (uint32_t)llround(seconds * sim.f0_cfg * cfg.tol_ppm * 1e-6 / SIM_TICKS);
+}
+
+uint32_t sim_config_gen(void)
+{
+    return sim.gen;
+}
+
+uint32_t sim_snapshot_err(uint32_t seconds)
+{
+    switch (seconds) {
+    case 1:  return (uint32_t)sim.snap_1s;
+    case 10: return (uint32_t)sim.snap_10s;
+    default: return (uint32_t)sim.snap_100s;
+    }
+}
+
+uint32_t sim_long_tol(void)
+{
+#ifdef SIM_LONG_LEN
+    uint32_t tol = (uint32_t)llround(SIM_LONG_LEN * sim.f0_cfg * SIM_LONG_PPB * 1e-9 / SIM_TICKS);
+
+    return (tol < 1) ? 1 : tol;
+#else
+    return 0;
+#endif
+}
+
+uint32_t sim_long_error(void)
+{
+    return (uint32_t)sim.long_error;
+}
+
+uint32_t sim_long_seq(void)
+{
+    return sim.long_seq;
+}
+
+void sim_long_restart(void)
+{
+    sim.long_restart = true;
+}
+
+uint32_t sim_ts_timestamp(void)
+{
+    return (uint32_t)sim.ts;
+}
+
+uint32_t sim_ts_phase(void)
+{
+    return (uint32_t)sim.ts_phase;
+}
+
+void sim_ts_realign(void)
+{
+    sim.realign = true;
+}
+
+uint32_t sim_ts_pending(void)
+{
+    return sim.ts_pending ? 1 : 0;
+}
+
+void sim_ts_ack(void)
+{
+    sim.ts_pending = false;
+}
+
+int16_t sim_temp(void)
+{
+    return (int16_t)lround(sim_temperature((double)sim.t / SIM_TICKS) * 16.0);
+}
+
+void sim_uart_write(uint8_t data)
+{
+    if (cfg.telemetry) {
+        fputc(data, cfg.telemetry);
+    }
+}
+
+void sim_dac_frac(uint32_t frac)
+{
+    sim.dac_frac = frac;
+}
+
+void sim_lock_quality(int field, uint32_t value)
+{
+    sim.lq[field] = value;
+}
+
+void sim_pps_select(uint32_t sel)
+{
+    if (sel != sim.pps_sel) {
+        sim.pps_switches++;
+    }
+    sim.pps_sel = sel;
+}
+
+uint32_t sim_pps_sources_active(void)
+{
+    return sim.src_active;
+}
+
+void sim_pps_rd_source(uint32_t source)
+{
+    sim.pps_rd = source % SIM_PPS_SOURCES_MAX;
+}
+
+uint32_t sim_pps_rd_timestamp(void)
+{
+    return sim.src_ts[sim.pps_rd];
+}
+
+uint32_t sim_pps_rd_count(void)
+{
+    return sim.src_count[sim.pps_rd];
+}
+
+/* Warm start calibration: the model tuning slope (Q16.16, DAC counts per
+   1s error count) and the DAC value cancelling the model offset. */
+uint32_t sim_cal_warm_start(void)
+{
+    return cfg.warm ? 1 : 0;
+}
+
+uint32_t sim_cal_warm_slope(void)
+{
+    return (uint32_t)(int32_t)llround(65536.0 / (cfg.slope_ppb * 1e-9 * sim.f0_cfg / SIM_TICKS));
+}
+
+uint32_t sim_cal_warm_dac(void)
+{
+    double dac = SIM_DAC_MID - cfg.offset_ppb / cfg.slope_ppb;
+
+    return (uint32_t)((dac < 0.0) ? 0 : (dac > 65535.0) ? 65535 : lround(dac));
+}
+
+void sim_cal_slope(uint32_t slope)
+{
+    sim.cal_slope = slope;
+}
+
+void sim_outlier_rejected(uint32_t count)
+{
+    sim.rejected = count;
+}
+
+void sim_history_data(int index, uint32_t value)
+{
+    sim.history[index] = value;
+}
+
+void sim_history_push(void)
+{
+    sim.history_seq++;
+}
+
+/*-----------------------------------------------------------------------*/
+/* Main                                                                  */
+/*-----------------------------------------------------------------------*/
+
+/* Loads a replayed trace: CSV records t,pps,ppb[,pps_ns[,temp_c]], one per
+   second (empty fields: not recorded, comment and header lines skipped). */
+static bool sim_replay_load(const char *path)
+{
+    sim_replay_t *r    = &cfg.replay;
+    uint32_t      size = 0;
+    double        t0   = 0.0;
+    char          line[256];
+    FILE         *f;
+
+    f = fopen(path, "r");
+    if (f == NULL) {
+        perror(path);
+        return false;
+    }
+    while (fgets(line, sizeof(line), f) != NULL) {
+        double fields[5];
+        char  *p = line;
+
+        if ((line[0] < '0') || (line[0] > '9')) {
+            continue;
+        }
+        for (int i = 0; i < 5; i++) {
+            char *end;
+
+            fields[i] = NAN;
+            if (p != NULL) {
+                double value = strtod(p, &end);
+                if (end != p) {
+                    fields[i] = value;
+                }
+                p = strchr(p, ',');
+                p = (p != NULL) ? p + 1 : NULL;
+            }
+        }
+        if (r->n == 0) {
+            t0 = fields[0];
+        }
+        if (fields[0] != t0 + r->n) {
+            fprintf(stderr, "%s: records must be one per second (t=%g).\n", path, fields[0]);
+            fclose(f);
+            return false;
+        }
+        if (r->n == size) {
+            size    = size ? 2 * size : 4096;
+            r->pps    = realloc(r->pps,    size * sizeof(*r->pps));
+            r->ppb    = realloc(r->ppb,    size * sizeof(*r->ppb));
+            r->pps_ns = realloc(r->pps_ns, size * sizeof(*r->pps_ns));
+            r->temp   = realloc(r->temp,   size * sizeof(*r->temp));
+            if (!r->pps || !r->ppb || !r->pps_ns || !r->temp) {
+                fprintf(stderr, "%s: out of memory.\n", path);
+                fclose(f);
+                return false;
+            }
+        }
+        r->pps[r->n]    = isnan(fields[1]) || (fields[1] != 0.0);
+        r->ppb[r->n]    = fields[2];
+        r->pps_ns[r->n] = fields[3];
+        r->temp[r->n]   = fields[4];
+        r->n++;
+    }
+    fclose(f);
+    if (r->n == 0) {
+        fprintf(stderr, "%s: no records.\n", path);
+        return false;
+    }
+    return true;
+}
+
+static void usage(const char *name)
+{
+    printf("Usage: %s [options]\n"
+        "  -n, --seconds N       Simulated time in seconds (default: %u).\n"
+        "  -s, --seed N          Noise generator seed (default: %llu).\n"
+        "  -f, --freq HZ         VCTCXO nominal frequency (default: %.0f).\n"
+        "  -p, --tol PPM         Tamer tolerance (default: %g).\n"
+        "  -o, --offset PPB      VCTCXO offset at mid-scale DAC (default: %g).\n"
+        "  -k, --slope PPB       VCTCXO tuning slope per DAC count (default: %g).\n"
+        "  -w, --white PPB       White frequency noise, rms (default: %g).\n"
+        "  -r, --walk PPB        Random walk frequency noise per sqrt(s) (default: %g).\n"
+        "  -d, --drift PPB       Aging per hour (default: %g).\n"
+        "  -T, --temp C,S,PPB    Temperature swing amplitude, period, coefficient (default: none).\n"
+        "  -j, --jitter NS       PPS jitter, rms (default: %g).\n"
+        "  -e, --enable S        Tamer enable time (default: %u).\n"
+        "  -h, --holdover S,LEN  PPS outage start and length (default: none).\n"
+        "  -l, --lock PPB        Lock threshold (default: tolerance).\n"
+        "  -b, --bad S,NS        PPS source 0 jitter from S, rms (0: source lost, SIM_PPS_INPUTS).\n"
+        "  -g, --clock S,HZ      RF clock change at S, with the configuration (default: none).\n"
+        "  -R, --replay FILE     Replay a recorded CSV trace (t,pps,ppb[,pps_ns[,temp_c]]),\n"
+        "                        one record per second, for its length unless -n is given.\n"
+        "  -W, --warm            Warm start from the model calibration (SIM_CALIBRATION).\n"
+        "  -c, --cpu             Report the firmware host CPU time per main loop iteration.\n"
+        "  -t, --trace FILE      Per-second CSV trace (t,dac,state,ppb,pps,err_1s).\n"
+        "  -u, --uart FILE       Firmware UART output (telemetry frames).\n",
+        name, cfg.seconds, (unsigned long long)cfg.seed, cfg.f0, cfg.tol_ppm, cfg.offset_ppb,
+        cfg.slope_ppb, cfg.white_ppb, cfg.walk_ppb, cfg.drift_ppb, cfg.jitter_ns, cfg.enable_at);
+}
+
+int main(int argc, char **argv)
+{
+    static const struct option options[] = {
+        {"seconds",  required_argument, NULL, 'n'},
+        {"seed",     required_argument, NULL, 's'},
+        {"freq",     required_argument, NULL, 'f'},
+        {"tol",      required_argument, NULL, 'p'},
+        {"offset",   required_argument, NULL, 'o'},
+        {"slope",    required_argument, NULL, 'k'},
+        {"white",    required_argument, NULL, 'w'},
+        {"walk",     required_argument, NULL, 'r'},
+        {"drift",    required_argument, NULL, 'd'},
+        {"temp",     required_argument, NULL, 'T'},
+        {"jitter",   required_argument, NULL, 'j'},
+        {"enable",   required_argument, NULL, 'e'},
+        {"holdover", required_argument, NULL, 'h'},
+        {"lock",     required_argument, NULL, 'l'},
+        {"bad",      required_argument, NULL, 'b'},
+        {"clock",    required_argument, NULL, 'g'},
+        {"replay",   required_argument, NULL, 'R'},
+        {"warm",     no_argument,       NULL, 'W'},
+        {"cpu",      no_argument,       NULL, 'c'},
+        {"trace",    required_argument, NULL, 't'},
+        {"uart",     required_argument, NULL, 'u'},
+        {NULL, 0, NULL, 0},
+    };
+    bool seconds = false;
+    int  opt;
+
+    while ((opt = getopt_long(argc, argv, "n:s:f:p:o:k:w:r:d:T:j:e:h:l:b:g:R:Wct:u:", options, NULL)) != -1) {
+        switch (opt) {
+        case 'n': cfg.seconds    = strtoul(optarg, NULL, 0); seconds = true; break;
+        case 's': cfg.seed       = strtoull(optarg, NULL, 0); break;
+        case 'f': cfg.f0         = atof(optarg); break;
+        case 'p': cfg.tol_ppm    = atof(optarg); break;
+        case 'o': cfg.offset_ppb = atof(optarg); break;
+        case 'k': cfg.slope_ppb  = atof(optarg); break;
+        case 'w': cfg.white_ppb  = atof(optarg); break;
+        case 'r': cfg.walk_ppb   = atof(optarg); break;
+        case 'd': cfg.drift_ppb  = atof(optarg); break;
+        case 'j': cfg.jitter_ns  = atof(optarg); break;
+        case 'e': cfg.enable_at  = strtoul(optarg, NULL, 0); break;
+        case 'l': cfg.lock_ppb   = atof(optarg); break;
+        case 'W': cfg.warm       = true; break;
+        case 'c': cfg.cpu        = true; break;
+        case 'R':
+            if (!sim_replay_load(optarg)) {
+                return 1;
+            }
+            break;
+        case 'T':
+            if (sscanf(optarg, "%lf,%lf,%lf", &cfg.temp_amp, &cfg.temp_period, &cfg.temp_coef_ppb) < 2) {
+                usage(argv[0]);
+                return 1;
+            }
+            break;
+        case 'b':
+            if (sscanf(optarg, "%u,%lf", &cfg.bad_start, &cfg.bad_jitter_ns) != 2) {
+                usage(argv[0]);
+                return 1;
+            }
+            break;
+        case 'g':
+            if (sscanf(optarg, "%u,%lf", &cfg.clk_at, &cfg.clk_f0) != 2) {
+                usage(argv[0]);
+                return 1;
+            }
+            break;
+        case 'h':
+            if (sscanf(optarg, "%u,%u", &cfg.outage_start, &cfg.outage_len) != 2) {
+                usage(argv[0]);
+                return 1;
+            }
+            break;
+        case 't':
+        case 'u':
+            {
+                FILE *f = fopen(optarg, (opt == 't') ? "w" : "wb");
+                if (f == NULL) {
+                    perror(optarg);
+                    return 1;
+                }
+                if (opt == 't') {
+                   cfg.trace = f;
+                } else {
+                   cfg.telemetry = f;
+                }
+            }
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if ((cfg.replay.n != 0) && !seconds) {
+        cfg.seconds = cfg.replay.n;
+    }
+
+    memset(&sim, 0, sizeof(sim));
+    sim.rng           = cfg.seed;
+    sim.f0            = cfg.f0;
+    sim.f0_cfg        = cfg.f0;
+    sim.fine_time     = -1;
+    sim.accuracy_time = -1;
+
+    /* The firmware main loop never returns: the model ends the run. */
+    if (setjmp(sim_end) == 0) {
+        firmware_main();
+    }
+
+    /* Summary (key=value): lock time from enable (-1: never locked), frequency
+       error after lock and during the PPS outage. */
+    printf("seconds=%u lock_time=%ld unlocks=%u rms_ppb=%.3f max_ppb=%.3f holdover_max_ppb=%.3f "
+           "dac=%u dac_changes=%u state=%u\n",
+        sim.t / SIM_TICKS, sim.locked ? (long)sim.lock_time : -1L, sim.unlocks,
+        (sim.n == 0) ? 0.0 : sqrt(sim.sum2 / sim.n), sim.max, sim.holdover_max,
+        sim_dac(), sim.dac_changes, sim.state);
+    /* Convergence (-1: never reached) and firmware host CPU time. */
+    printf("fine_time=%d accuracy_time=%d accuracy=%u\n", sim.fine_time, sim.accuracy_time,
+        sim.accuracy);
+    if (cfg.cpu) {
+        printf("cpu_ns=%.0f cpu_ns_max=%.0f\n", (sim.cpu_n == 0) ? 0.0 : sim.cpu_sum / sim.cpu_n,
+            sim.cpu_max);
+    }
+#ifdef SIM_PPS_INPUTS
+    printf("pps_source=%u pps_switches=%u\n", sim.pps_sel, sim.pps_switches);
+#endif
+#ifdef SIM_LOCK_QUALITY
+    /* Firmware view: lock decision and 1s statistics (counts). */
+    printf("fw_locked=%u fw_lock_time=%u fw_mean_1s=%.3f fw_rms_1s=%.3f fw_max_1s=%.3f "
+           "fw_rms_10s=%.3f fw_rms_100s=%.3f\n",
+        sim.lq[SIM_LQ_LOCKED], sim.lq[SIM_LQ_LOCK_TIME], (int32_t)sim.lq[SIM_LQ_MEAN_1S] / 256.0,
+        sim.lq[SIM_LQ_RMS_1S] / 256.0, sim.lq[SIM_LQ_MAX_1S] / 256.0,
+        sim.lq[SIM_LQ_RMS_10S] / 256.0, sim.lq[SIM_LQ_RMS_100S] / 256.0);
+#endif
+#ifdef SIM_LONG_LEN
+    printf("long_windows=%u long_error=%d\n", sim.long_seq, sim.long_error);
+#endif
+#ifdef SIM_CALIBRATION
+    /* Firmware view: last published calibration slope (DAC counts/count). */
+    printf("cal_slope=%.3f\n", (int32_t)sim.cal_slope / 65536.0);
+#endif
+#ifdef SIM_OUTLIER_WINDOW
+    printf("outlier_rejected=%u\n", sim.rejected);
+#endif
+#ifdef SIM_HISTORY
+    printf("history_samples=%u\n", sim.history_seq);
+#endif
+
+    if (cfg.trace) {
+        fclose(cfg.trace);
+    }
+    if (cfg.telemetry) {
+        fclose(cfg.telemetry);
+    }
+    return 0;
+}
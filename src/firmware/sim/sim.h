@@ -0,0 +1,97 @@
+/*--------------------------------------------------------------------------
+-- FILE        : sim.h
+-- DESCRIPTION : Host simulation of the PPSDO (VCTCXO, PPS and VCTCXO
+--               Tamer models) header file.
+-- DATE        :
+-- AUTHOR(s)   : Lime Microsystems.
+-- REVISIONS   :
+--------------------------------------------------------------------------*/
+
+#ifndef SIM_H_
+#define SIM_H_
+
+#include <stdint.h>
+
+/*-----------------------------------------------------------------------*/
+/* Function Prototypes (model side of the CSR accessors)                 */
+/*-----------------------------------------------------------------------*/
+
+uint32_t sim_tamer_status(void);
+
+uint32_t sim_pps_active(void);
+
+uint32_t sim_target(uint32_t seconds);
+
+uint32_t sim_tol(uint32_t seconds);
+
+uint32_t sim_config_gen(void);
+
+/* VCTCXO Tamer snapshot (SIM_SNAPSHOT) and long window (SIM_LONG_LEN). */
+uint32_t sim_snapshot_err(uint32_t seconds);
+
+uint32_t sim_long_tol(void);
+
+uint32_t sim_long_error(void);
+
+uint32_t sim_long_seq(void);
+
+void sim_long_restart(void);
+
+uint32_t sim_ts_timestamp(void);
+
+uint32_t sim_ts_phase(void);
+
+void sim_ts_realign(void);
+
+uint32_t sim_ts_pending(void);
+
+void sim_ts_ack(void);
+
+int16_t sim_temp(void);
+
+void sim_uart_write(uint8_t data);
+
+void sim_dac_frac(uint32_t frac);
+
+/* Firmware lock quality outputs (SIM_LOCK_QUALITY). */
+enum {
+    SIM_LQ_MEAN_1S, SIM_LQ_RMS_1S, SIM_LQ_MAX_1S,
+    SIM_LQ_MEAN_10S, SIM_LQ_RMS_10S, SIM_LQ_MAX_10S,
+    SIM_LQ_MEAN_100S, SIM_LQ_RMS_100S, SIM_LQ_MAX_100S,
+    SIM_LQ_LOCKED, SIM_LQ_LOCK_TIME,
+    SIM_LQ_COUNT
+};
+
+void sim_lock_quality(int field, uint32_t value);
+
+/* PPS sources (SIM_PPS_INPUTS). */
+void sim_pps_select(uint32_t sel);
+
+uint32_t sim_pps_sources_active(void);
+
+void sim_pps_rd_source(uint32_t source);
+
+uint32_t sim_pps_rd_timestamp(void);
+
+uint32_t sim_pps_rd_count(void);
+
+/* Calibration (SIM_CALIBRATION). */
+uint32_t sim_cal_warm_start(void);
+
+uint32_t sim_cal_warm_slope(void);
+
+uint32_t sim_cal_warm_dac(void);
+
+void sim_cal_slope(uint32_t slope);
+
+/* Outlier filter (SIM_OUTLIER_WINDOW) and error history (SIM_HISTORY). */
+void sim_outlier_rejected(uint32_t count);
+
+void sim_history_data(int index, uint32_t value);
+
+void sim_history_push(void);
+
+/* Firmware entry point (main.c main(), renamed). */
+int firmware_main(void);
+
+#endif /* SIM_H_ */
@@ -0,0 +1,218 @@
+#!/usr/bin/env python3
+
+#
+# This file is part of LimePSB_RPCM_GW.
+#
+# Copyright (c) 2024-2025 Lime Microsystems.
+# SPDX-License-Identifier: Apache-2.0
+#
+# PPSDO firmware ROM/SRAM budget report: section and per-symbol sizes, library members pulled in
+# and worst-case stack depth (from the disassembly call graph). Fails when a budget is exceeded.
+#
+
+import re
+import sys
+import argparse
+import subprocess
+
+# Constants ----------------------------------------------------------------------------------------
+
+# Sections loaded in ROM / SRAM (.data is stored in ROM and copied to SRAM by crt0).
+ROM_SECTIONS  = [".text", ".rodata", ".data"]
+SRAM_SECTIONS = [".data", ".bss"]
+
+# Call graph roots: main context and trap (interrupt) context, the latter preempting the former.
+MAIN_ROOTS = ["_start", "main"]
+TRAP_ROOTS = ["trap_entry", "isr"]
+
+# Helpers ------------------------------------------------------------------------------------------
+
+def run(cmd):
+    return subprocess.run(cmd, check=True, capture_output=True, text=True).stdout
+
+def read_regions(path):
+    """Get the memory region lengths from the LiteX generated regions.ld."""
+    regions = {}
+    with open(path) as f:
+        for m in re.finditer(r"(\w+)\s*:\s*ORIGIN\s*=\s*(0x[0-9a-fA-F]+|\d+)\s*,\s*LENGTH\s*=\s*(0x[0-9a-fA-F]+|\d+)", f.read()):
+            regions[m.group(1)] = int(m.group(3), 0)
+    return regions
+
+def read_sections(prefix, elf):
+    """Get the section sizes (size -A)."""
+    sections = {}
+    for line in run([prefix + "size", "-A", elf]).splitlines():
+        fields = line.split()
+        if len(fields) == 3 and fields[0].startswith(".") and fields[1].isdigit():
+            sections[fields[0]] = int(fields[1])
+    return sections
+
+def read_symbols(prefix, elf):
+    """Get the sized symbols as (size, type, name), largest first."""
+    symbols = []
+    for line in run([prefix + "nm", "-S", "--size-sort", "-t", "d", elf]).splitlines():
+        fields = line.split()
+        if len(fields) == 4:
+            symbols.append((int(fields[1]), fields[2], fields[3]))
+    return sorted(symbols, reverse=True)
+
+def read_archive_members(path):
+    """Get the archive members pulled in by the link as (member, referenced by), from the map."""
+    members = []
+    with open(path) as f:
+        lines = f.read().splitlines()
+    try:
+        start = lines.index("Archive member included to satisfy reference by file (symbol)")
+    except ValueError:
+        return members
+    member = None
+    for line in lines[start + 1:]:
+        if line.startswith(("Discarded input sections", "Memory Configuration", "Allocating common symbols")):
+            break
+        if not line.strip():
+            continue
+        if not line[0].isspace():
+            member = line.split()[0].split("/")[-1]
+            if len(line.split()) > 1:
+                members.append((member, line.split(None, 1)[1].strip()))
+                member = None
+        elif member is not None:
+            members.append((member, line.strip().split("/")[-1]))
+            member = None
+    return members
+
+# Stack Depth --------------------------------------------------------------------------------------
+
+def read_call_graph(prefix, elf):
+    """Get the per-function frame size and callees from the disassembly.
+
+    Returns {function: (frame, callees, indirect)}; indirect is set on calls through a register.
+    """
+    functions = {}
+    current   = None
+    for line in run([prefix + "objdump", "-d", "--no-show-raw-insn", elf]).splitlines():
+        m = re.match(r"^[0-9a-f]+ <([^>]+)>:$", line)
+        if m:
+            current = [0, set(), False]
+            functions[m.group(1)] = current
+            continue
+        if current is None or ":" not in line:
+            continue
+        insn = line.split(":", 1)[1].split()
+        if not insn:
+            continue
+        op, args = insn[0], "".join(insn[1:])
+        # Frame allocation (the prologue; the largest one is kept).
+        m = re.match(r"^(?:c\.)?addi(?:16sp)?$", op) and re.match(r"^sp,(?:sp,)?-(\d+)", args)
+        if m:
+            current[0] = max(current[0], int(m.group(1)))
+        # Direct calls and tail calls to other functions (<name+0x..> targets are local branches).
+        m = re.search(r"<([^>+]+)>", args)
+        if op in ["jal", "j", "c.jal", "c.j", "call", "tail", "jalr"] and m:
+            current[1].add(m.group(1))
+        elif op in ["jalr", "c.jalr"]:
+            current[2] = True
+    return {name: (f[0], f[1], f[2]) for name, f in functions.items()}
+
+def stack_depth(graph, root):
+    """Get the worst-case stack depth from root, with the deepest path.
+
+    Returns (depth, path, flags): flags lists the reasons for the depth being a lower bound.
+    """
+    flags = set()
+    cache = {}
+    def walk(name, active):
+        if name in active:
+            flags.add(f"recursion in {name}")
+            return 0, []
+        if name in cache:
+            return cache[name]
+        frame, callees, indirect = graph.get(name, (0, set(), False))
+        if indirect:
+            flags.add(f"indirect call in {name}")
+        best = (0, [])
+        for callee in callees:
+            if callee != name:
+                depth, path = walk(callee, active | {name})
+                best = max(best, (depth, path))
+        cache[name] = (frame + best[0], [name] + best[1])
+        return cache[name]
+    depth, path = walk(root, frozenset())
+    return depth, path, sorted(flags)
+
+def find_root(graph, roots):
+    for root in roots:
+        if root in graph:
+            return root
+    return None
+
+# Report -------------------------------------------------------------------------------------------
+
+def main():
+    parser = argparse.ArgumentParser(description="PPSDO firmware ROM/SRAM budget report.")
+    parser.add_argument("elf",                                 help="Firmware ELF file.")
+    parser.add_argument("--prefix",      default="",           help="Toolchain prefix (e.g. riscv64-unknown-elf-).")
+    parser.add_argument("--regions",     default=None,         help="LiteX generated regions.ld (ROM/SRAM budgets).")
+    parser.add_argument("--map",         default=None,         help="Linker map file (library members report).")
+    parser.add_argument("--rom-budget",  default=None, type=lambda x: int(x, 0), help="ROM budget in bytes (default: from regions.ld).")
+    parser.add_argument("--sram-budget", default=None, type=lambda x: int(x, 0), help="SRAM budget in bytes (default: from regions.ld).")
+    parser.add_argument("--top",         default=20,   type=int, help="Number of symbols to list (default: 20).")
+    args = parser.parse_args()
+
+    regions     = read_regions(args.regions) if args.regions else {}
+    rom_budget  = args.rom_budget  if args.rom_budget  is not None else regions.get("rom")
+    sram_budget = args.sram_budget if args.sram_budget is not None else regions.get("sram")
+
+    sections = read_sections(args.prefix, args.elf)
+    symbols  = read_symbols(args.prefix, args.elf)
+    graph    = read_call_graph(args.prefix, args.elf)
+
+    # Symbols.
+    print(f"Largest symbols (of {len(symbols)}):")
+    for size, kind, name in symbols[:args.top]:
+        print(f"  {size:6d} {kind} {name}")
+
+    # Library members.
+    if args.map:
+        members = read_archive_members(args.map)
+        print(f"Library members pulled in ({len(members)}):")
+        for member, reference in members:
+            print(f"  {member:32} <- {reference}")
+
+    # Stack.
+    main_root = find_root(graph, MAIN_ROOTS)
+    trap_root = find_root(graph, TRAP_ROOTS)
+    main_depth, main_path, main_flags = stack_depth(graph, main_root) if main_root else (0, [], [])
+    trap_depth, trap_path, trap_flags = stack_depth(graph, trap_root) if trap_root else (0, [], [])
+    stack = main_depth + trap_depth
+    print("Stack depth:")
+    print(f"  main {main_depth:5d} bytes: {' > '.join(main_path)}")
+    print(f"  trap {trap_depth:5d} bytes: {' > '.join(trap_path)}")
+    for flag in main_flags + trap_flags:
+        print(f"  warning: lower bound, {flag}")
+
+    # Budgets.
+    rom  = sum(sections.get(s, 0) for s in ROM_SECTIONS)
+    sram = sum(sections.get(s, 0) for s in SRAM_SECTIONS) + stack
+    ok   = True
+    print("Budget:")
+    for name, used, budget, detail in [
+        ("ROM",  rom,  rom_budget,  " + ".join(f"{s} {sections.get(s, 0)}" for s in ROM_SECTIONS)),
+        ("SRAM", sram, sram_budget, " + ".join(f"{s} {sections.get(s, 0)}" for s in SRAM_SECTIONS) + f" + stack {stack}")]:
+        if budget is None:
+            print(f"  {name:4} {used:6d} bytes ({detail}), no budget")
+            continue
+        status = "OK" if used <= budget else "EXCEEDED"
+        ok    &= (used <= budget)
+        print(f"  {name:4} {used:6d} / {budget:6d} bytes ({100*used/budget:5.1f}%, {detail}): {status}")
+
+    if not ok:
+        # Smallest power of 2 sizes fitting the firmware (SoC ROM/SRAM sizes).
+        fit = lambda used: 1 << max(used - 1, 1).bit_length()
+        print("Firmware exceeds its ROM/SRAM budget, build the SoC with at least: "
+              f"ppsdo_gen.py --rom-size={max(fit(rom), rom_budget or 0):#x} "
+              f"--sram-size={max(fit(sram), sram_budget or 0):#x}", file=sys.stderr)
+        sys.exit(1)
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,102 @@
+/*--------------------------------------------------------------------------
+-- FILE        : telemetry.c
+-- DESCRIPTION : Binary UART telemetry file.
+-- DATE        :
+-- AUTHOR(s)   : Lime Microsystems.
+-- REVISIONS   :
+--------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <generated/soc.h>
+#include <generated/csr.h>
+
+#include "telemetry.h"
+
+#if defined(CONFIG_TELEMETRY) && defined(CSR_UART_BASE)
+
+/*-----------------------------------------------------------------------*/
+/* Global Variables                                                      */
+/*-----------------------------------------------------------------------*/
+
+static uint8_t tlm_seq;
+
+/*-----------------------------------------------------------------------*/
+/* Helpers                                                               */
+/*-----------------------------------------------------------------------*/
+
+/* Updates a CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF) with one byte. */
+static uint16_t tlm_crc16(uint16_t crc, uint8_t data)
+{
+    crc ^= (uint16_t)data << 8;
+    for (uint8_t i = 0; i < 8; i++) {
+        crc = (crc & 0x8000) ? ((crc << 1) ^ 0x1021) : (crc << 1);
+    }
+    return crc;
+}
+
+/* Writes one byte to the UART TX FIFO (never full: see telemetry_send). */
+static uint16_t tlm_put(uint16_t crc, uint8_t data)
+{
+    uart_rxtx_write(data);
+    return tlm_crc16(crc, data);
+}
+
+/* Writes a 32-bit little-endian field. */
+static uint16_t tlm_put32(uint16_t crc, uint32_t data)
+{
+    for (uint8_t i = 0; i < 4; i++) {
+        crc = tlm_put(crc, data & 0xFF);
+        data >>= 8;
+    }
+    return crc;
+}
+
+/*-----------------------------------------------------------------------*/
+/* Functions                                                             */
+/*-----------------------------------------------------------------------*/
+
+/* Sends a telemetry frame without blocking.
+ * The UART TX FIFO is sized for a full frame and used as the ring buffer:
+ * the frame is only written when the FIFO is empty (shifted out by the
+ * UART while the firmware goes on), otherwise it is dropped, which the host
+ * sees as a sequence number gap.
+ *
+ * @param pkt        The PPS measurement.
+ * @param state      The tuning state.
+ * @param pps_active PPS present.
+ */
+void telemetry_send(const struct vctcxo_tamer_pkt_buf *pkt, state_t state, bool pps_active)
+{
+    uint8_t  seq   = tlm_seq++;
+    uint8_t  flags = 0;
+    uint16_t crc   = 0xFFFF;
+
+    if (!uart_txempty_read()) {
+        return;
+    }
+
+    flags |= pkt->pps_1s_error_flag   ? VT_STAT_ERR_1S   : 0;
+    flags |= pkt->pps_10s_error_flag  ? VT_STAT_ERR_10S  : 0;
+    flags |= pkt->pps_100s_error_flag ? VT_STAT_ERR_100S : 0;
+    flags |= pkt->pps_long_error_flag ? VT_STAT_ERR_LONG : 0;
+    flags |= pps_active               ? TLM_FLAG_PPS_ACTIVE : 0;
+
+    uart_rxtx_write(TLM_SYNC0);
+    uart_rxtx_write(TLM_SYNC1);
+    crc = tlm_put(crc, seq);
+    crc = tlm_put(crc, (uint8_t)state);
+    crc = tlm_put(crc, flags);
+    crc = tlm_put(crc, vctcxo_trim_dac_value & 0xFF);
+    crc = tlm_put(crc, vctcxo_trim_dac_value >> 8);
+    crc = tlm_put32(crc, (uint32_t)pkt->pps_1s_error);
+    crc = tlm_put32(crc, (uint32_t)pkt->pps_10s_error);
+    crc = tlm_put32(crc, (uint32_t)pkt->pps_100s_error);
+    crc = tlm_put32(crc, (uint32_t)pkt->pps_long_error);
+    crc = tlm_put32(crc, (uint32_t)pkt->pps_phase_error);
+    uart_rxtx_write(crc & 0xFF);
+    uart_rxtx_write(crc >> 8);
+}
+
+#endif
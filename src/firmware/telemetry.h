@@ -0,0 +1,62 @@
+/*--------------------------------------------------------------------------
+-- FILE        : telemetry.h
+-- DESCRIPTION : Binary UART telemetry header file.
+-- DATE        :
+-- AUTHOR(s)   : Lime Microsystems.
+-- REVISIONS   :
+--------------------------------------------------------------------------*/
+
+#ifndef TELEMETRY_H_
+#define TELEMETRY_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <generated/soc.h>
+#include <generated/csr.h>
+
+#include "vctcxo_tamer.h"
+
+/*-----------------------------------------------------------------------*/
+/* Frame Format                                                          */
+/*-----------------------------------------------------------------------*/
+
+/* One frame per processed PPS measurement (or HOLDOVER step), multi-byte
+   fields little-endian:
+     [0]     Sync (0xA5).
+     [1]     Sync (0x5A).
+     [2]     Sequence number (increments on dropped frames too).
+     [3]     Tuning state (state_t).
+     [4]     Flags (TLM_FLAG_*).
+     [5:6]   Trim DAC value.
+     [7:10]  1s error.
+     [11:14] 10s error.
+     [15:18] 100s error.
+     [19:22] Long window error.
+     [23:26] PPS phase error (continuous-count mode only).
+     [27:28] CRC-16/CCITT-FALSE of bytes [2:26]. */
+#define TLM_SYNC0            0xA5
+#define TLM_SYNC1            0x5A
+#define TLM_FRAME_SIZE       29
+
+/* Flags: error flags in the VT_STAT_ERR_* bit positions, PPS active. */
+#define TLM_FLAG_ERR_MASK    0x0F
+#define TLM_FLAG_PPS_ACTIVE  (1<<4)
+
+/*-----------------------------------------------------------------------*/
+/* Function Prototypes                                                   */
+/*-----------------------------------------------------------------------*/
+
+#if defined(CONFIG_TELEMETRY) && defined(CSR_UART_BASE)
+
+void telemetry_send(const struct vctcxo_tamer_pkt_buf *pkt, state_t state, bool pps_active);
+
+#else
+
+static inline void telemetry_send(const struct vctcxo_tamer_pkt_buf *pkt, state_t state, bool pps_active) {
+    (void)pkt; (void)state; (void)pps_active;
+}
+
+#endif
+
+#endif /* TELEMETRY_H_ */
@@ -9,9 +9,12 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#include <generated/soc.h>
 #include <generated/mem.h>
+#include <generated/csr.h>
 
 #include "vctcxo_tamer.h"
+#include "profile.h"
 
 /*-----------------------------------------------------------------------*/
 /* Global Variables                                                      */
@@ -20,6 +23,9 @@
 /* Cached version of the VCTCXO Tamer control register. */
 uint8_t vctcxo_tamer_ctrl_reg;
 
+/* Current tuning mode. */
+uint8_t vctcxo_tamer_tune_mode;
+
 /* Global variable containing the current VCTCXO DAC setting. This is a 'cached'
    value of what is written to the DAC and is used by the VCTCXO calibration
    algorithm to avoid constant read requests going out to the DAC. Initial
@@ -27,10 +33,44 @@ uint8_t vctcxo_tamer_ctrl_reg;
  */
 uint16_t vctcxo_trim_dac_value;
 
+/* Fractional part of the current VCTCXO DAC setting (DAC dither). */
+uint16_t vctcxo_trim_dac_frac;
+
+#ifdef CSR_PPS_TIMESTAMP_BASE
+/* Continuous-count measurement state: last PPS timestamp and start of the
+   current 10s/100s windows (in RF clock counts). */
+static bool     pps_ts_valid;
+static uint32_t pps_ts_last;
+static uint32_t pps_ts_start_10s;
+static uint32_t pps_ts_start_100s;
+static uint8_t  pps_ts_count_10s;
+static uint8_t  pps_ts_count_100s;
+#endif
+
+#ifdef CSR_VCTCXO_TAMER_LONG_BASE
+/* Long window: sequence of the last window read. */
+static uint32_t long_seq;
+#endif
+
+#ifdef CONFIG_DAC_SLEW
+/* DAC slew state: trim DAC value output to the Tamer (ramping towards
+   vctcxo_trim_dac_value), remaining settle ticks, and counters release
+   requested while the DAC was not settled. */
+static bool     dac_slew_valid;
+static bool     dac_slew_busy;
+static bool     dac_slew_release;
+static uint16_t dac_slew_value;
+static uint16_t dac_slew_settle;
+#endif
+
 /*-----------------------------------------------------------------------*/
 /* Functions                                                             */
 /*-----------------------------------------------------------------------*/
 
+/* Register accessors (the host simulation in sim/ provides a register-level
+   model of the VCTCXO Tamer instead). */
+#ifndef CONFIG_SIM
+
 /* Reads a byte from VCTCXO Tamer register. */
 uint8_t vctcxo_tamer_read(uint8_t addr) {
     return *(volatile uint8_t *)(VCTCXO_TAMER_BASE + 4*addr);
@@ -41,8 +81,18 @@ void vctcxo_tamer_write(uint8_t addr, uint8_t data) {
     *(volatile uint8_t *)(VCTCXO_TAMER_BASE + 4*addr) = data;
 }
 
+#endif
+
 /* Resets or releases the PPS counters. */
 void vctcxo_tamer_reset_counters(bool reset) {
+#ifdef CONFIG_DAC_SLEW
+    /* Release deferred until the DAC has settled (see vctcxo_trim_dac_slew_tick()). */
+    dac_slew_release = !reset && dac_slew_busy;
+    if (dac_slew_release) {
+        return;
+    }
+#endif
+
     if( reset ) {
         vctcxo_tamer_ctrl_reg |= VT_CTRL_RESET;
     } else {
@@ -86,9 +136,11 @@ void vctcxo_tamer_set_tune_mode(vctcxo_tamer_mode mode) {
             return;
     }
 
-    /* Set tuning mode. */
+    /* Set tuning mode (10 MHz: the reference is divided to ticks by the
+       gateware, that the Tamer counts as in the 1 PPS mode). */
+    vctcxo_tamer_tune_mode  = (uint8_t) mode;
     vctcxo_tamer_ctrl_reg &= ~VT_CTRL_TUNE_MODE;
-    vctcxo_tamer_ctrl_reg |= (((uint8_t) mode) << 6);
+    vctcxo_tamer_ctrl_reg |= (((uint8_t) ((mode == VCTCXO_TAMER_10_MHZ) ? VCTCXO_TAMER_1_PPS : mode)) << 6);
     vctcxo_tamer_write(VT_CTRL_ADDR, vctcxo_tamer_ctrl_reg);
 
     /* Reset the counters. */
@@ -126,14 +178,12 @@ int32_t vctcxo_tamer_read_count(uint8_t addr) {
     return value;
 }
 
-/* Writes the trim DAC value to VCTCXO Tamer registers. */
-void vctcxo_trim_dac_write(uint16_t val)
+/* Outputs a trim DAC value to the VCTCXO Tamer registers. */
+static void vctcxo_trim_dac_output(uint16_t val)
 {
     uint8_t tuned_val_lsb;
     uint8_t tuned_val_msb;
 
-    vctcxo_trim_dac_value = val;
-
     tuned_val_lsb = (uint8_t) ((val & 0x00FF) >> 0);
     tuned_val_msb = (uint8_t) ((val & 0xFF00) >> 8);
 
@@ -142,7 +192,170 @@ void vctcxo_trim_dac_write(uint16_t val)
     vctcxo_tamer_write(VT_DAC_TUNNED_VAL_ADDR1, tuned_val_msb);
 }
 
+/* Restarts the measurement windows from the new DAC value. */
+static void vctcxo_tamer_restart_windows(void)
+{
+#ifdef CSR_VCTCXO_TAMER_SNAPSHOT_BASE
+    /* The ISR no longer stops the counters: restart the measurement windows
+       from the new DAC value (released by the main loop). */
+    vctcxo_tamer_reset_counters(true);
+#endif
+
+#ifdef CSR_PPS_TIMESTAMP_BASE
+    /* Restart the 10s/100s windows from the new DAC value. */
+    pps_timestamp_restart();
+#endif
+
+#ifdef CSR_VCTCXO_TAMER_LONG_BASE
+    /* Restart the long window from the new DAC value. */
+    vctcxo_tamer_long_restart_write(1);
+#endif
+}
+
+/* Writes the trim DAC value (whole and fractional parts). */
+static void vctcxo_trim_dac_update(uint16_t val, uint16_t frac)
+{
+    vctcxo_trim_dac_value = val;
+
+#ifdef CSR_DAC_DITHER_BASE
+    if (frac != vctcxo_trim_dac_frac) {
+        vctcxo_trim_dac_frac = frac;
+        dac_dither_frac_write(frac);
+    }
+#else
+    (void)frac;
+#endif
+
+#ifdef CONFIG_DAC_SLEW
+    /* Ramp to the new value from the main loop slew ticks, measurements held
+       off until the DAC has settled (the first value is output directly). */
+    if (dac_slew_valid) {
+        dac_slew_busy   = true;
+        dac_slew_settle = DAC_SLEW_SETTLE_TICKS;
+        vctcxo_tamer_reset_counters(true);
+
+        /* PPS to DAC update latency (start of the ramp). */
+        prof_dac_mark();
+        return;
+    }
+    dac_slew_valid = true;
+    dac_slew_value = val;
+#endif
+
+    vctcxo_trim_dac_output(val);
+
+    /* PPS to DAC update latency. */
+    prof_dac_mark();
+
+    vctcxo_tamer_restart_windows();
+}
+
+/* Writes the trim DAC value to VCTCXO Tamer registers. */
+void vctcxo_trim_dac_write(uint16_t val)
+{
+    vctcxo_trim_dac_update(val, 0);
+}
+
+/* Writes the trim DAC value in 1/2^DAC_FRAC_BITS DAC counts (the fractional
+   part is dithered on the DAC output, dropped without the DAC dither). */
+void vctcxo_trim_dac_write_frac(uint32_t val)
+{
+    vctcxo_trim_dac_update((uint16_t)(val >> DAC_FRAC_BITS),
+                           (uint16_t)(val & ((1u << DAC_FRAC_BITS) - 1)));
+}
+
+/* Runs one DAC slew tick (called from the main loop every
+   CONFIG_DAC_SLEW_TICK_MS while vctcxo_trim_dac_slew_busy()): steps the DAC
+   output towards vctcxo_trim_dac_value, then waits for the settle interval
+   and restarts the measurements from the new DAC value. */
+void vctcxo_trim_dac_slew_tick(void) {
+#ifdef CONFIG_DAC_SLEW
+    int32_t delta = (int32_t)vctcxo_trim_dac_value - (int32_t)dac_slew_value;
+    int32_t step;
+    bool    release;
+
+    if (!dac_slew_busy) {
+        return;
+    }
+
+    if (delta != 0) {
+#ifdef CONFIG_DAC_SLEW_SHIFT
+        /* Exponential: 2^-N of the remaining step (at least one count). */
+        step = delta / (1 << CONFIG_DAC_SLEW_SHIFT);
+        if (step == 0) {
+            step = (delta < 0) ? -1 : 1;
+        }
+#else
+        /* Fixed step. */
+        step = delta;
+        if (step > CONFIG_DAC_SLEW_STEP) {
+            step = CONFIG_DAC_SLEW_STEP;
+        } else if (step < -CONFIG_DAC_SLEW_STEP) {
+            step = -CONFIG_DAC_SLEW_STEP;
+        }
+#endif
+        dac_slew_value = (uint16_t)((int32_t)dac_slew_value + step);
+        vctcxo_trim_dac_output(dac_slew_value);
+        return;
+    }
+
+    if (dac_slew_settle > 0) {
+        dac_slew_settle--;
+        return;
+    }
+
+    /* Settled: restart the measurements and release the counters if that
+       was requested in the meantime. */
+    release          = dac_slew_release;
+    dac_slew_busy    = false;
+    dac_slew_release = false;
+    vctcxo_tamer_restart_windows();
+    if (release) {
+        vctcxo_tamer_reset_counters(false);
+    }
+#endif
+}
+
+/* Returns true while the DAC is ramping or settling. */
+bool vctcxo_trim_dac_slew_busy(void) {
+#ifdef CONFIG_DAC_SLEW
+    return dac_slew_busy;
+#else
+    return false;
+#endif
+}
+
+/* Returns the long window length in seconds (0: disabled/not available). */
+uint16_t vctcxo_tamer_long_len(void) {
+#ifdef CSR_VCTCXO_TAMER_LONG_BASE
+    return vctcxo_tamer_long_len_read();
+#else
+    return 0;
+#endif
+}
+
+/* Reads the long window error into the packet buffer once per completed
+   window (the flag is cleared by the main loop once processed). */
+__attribute__((section(".text.isr")))
+static void vctcxo_tamer_long_read(struct vctcxo_tamer_pkt_buf *pkt) {
+#ifdef CSR_VCTCXO_TAMER_LONG_BASE
+    uint32_t seq = vctcxo_tamer_long_seq_read();
+    uint32_t magnitude;
+
+    if (seq != long_seq) {
+        long_seq = seq;
+        pkt->pps_long_error      = (int32_t)vctcxo_tamer_long_error_read();
+        magnitude                = (pkt->pps_long_error < 0) ? -(uint32_t)pkt->pps_long_error : (uint32_t)pkt->pps_long_error;
+        pkt->pps_long_error_flag = magnitude > vctcxo_tamer_long_tol_read();
+        pkt->pps_long_ready      = pkt->pps_long_error_flag;
+    }
+#else
+    (void)pkt;
+#endif
+}
+
 /* VCTCXO Tamer ISR handler. */
+__attribute__((section(".text.isr")))
 void vctcxo_tamer_isr(void *context) {
     struct vctcxo_tamer_pkt_buf *pkt = (struct vctcxo_tamer_pkt_buf *)context;
     uint8_t error_status = 0x00;
@@ -150,6 +363,13 @@ void vctcxo_tamer_isr(void *context) {
     /* Disable interrupts. */
     vctcxo_tamer_enable_isr(false);
 
+#ifdef CSR_VCTCXO_TAMER_SNAPSHOT_BASE
+    /* Read the count values latched on the IRQ edge (single word reads, the
+       PPS counters keep running). */
+    pkt->pps_1s_error   = (int32_t)vctcxo_tamer_snapshot_err_1s_read();
+    pkt->pps_10s_error  = (int32_t)vctcxo_tamer_snapshot_err_10s_read();
+    pkt->pps_100s_error = (int32_t)vctcxo_tamer_snapshot_err_100s_read();
+#else
     /* Reset (stop) the PPS counters. */
     vctcxo_tamer_reset_counters(true);
 
@@ -157,6 +377,7 @@ void vctcxo_tamer_isr(void *context) {
     pkt->pps_1s_error   = vctcxo_tamer_read_count(VT_ERR_1S_ADDR);
     pkt->pps_10s_error  = vctcxo_tamer_read_count(VT_ERR_10S_ADDR);
     pkt->pps_100s_error = vctcxo_tamer_read_count(VT_ERR_100S_ADDR);
+#endif
 
     /* Read the error status register. */
     error_status = vctcxo_tamer_read(VT_STAT_ADDR);
@@ -166,6 +387,9 @@ void vctcxo_tamer_isr(void *context) {
     pkt->pps_10s_error_flag  = (error_status & VT_STAT_ERR_10S)  ? true : false;
     pkt->pps_100s_error_flag = (error_status & VT_STAT_ERR_100S) ? true : false;
 
+    /* Long window. */
+    vctcxo_tamer_long_read(pkt);
+
     /* Clear interrupt. */
     vctcxo_tamer_clear_isr();
 
@@ -175,11 +399,149 @@ void vctcxo_tamer_isr(void *context) {
     return;
 }
 
+/* Long window ISR handler (also polled): reads a completed long window, that
+   the main loop processes on its own when the Tamer did not report a
+   measurement on the same PPS. */
+__attribute__((section(".text.isr")))
+void vctcxo_tamer_long_isr(void *context) {
+    vctcxo_tamer_long_read((struct vctcxo_tamer_pkt_buf *)context);
+}
+
+/* Resets the continuous-count measurement (next PPS timestamp is used as the
+   start of all windows). */
+void pps_timestamp_reset(void) {
+#ifdef CSR_PPS_TIMESTAMP_BASE
+    pps_ts_valid = false;
+#endif
+}
+
+/* Restarts the 10s/100s windows from the last PPS timestamp (the DAC is
+   updated right after a PPS, so the current 1s window is kept). */
+void pps_timestamp_restart(void) {
+#ifdef CSR_PPS_TIMESTAMP_BASE
+    pps_ts_start_10s  = pps_ts_last;
+    pps_ts_start_100s = pps_ts_last;
+    pps_ts_count_10s  = 0;
+    pps_ts_count_100s = 0;
+#endif
+}
+
+/* Requests the local 1s epoch to be realigned on the next PPS (the phase
+   error is then measured from zero). */
+void pps_timestamp_realign(void) {
+#ifdef CSR_PPS_TIMESTAMP_BASE
+    pps_timestamp_realign_write(1);
+#endif
+}
+
+/* Moves the continuous-count windows to another PPS source: offset is the
+   timestamp of the new source minus the one of the current source on the
+   same PPS epoch, so that the windows go on without a measurement gap. */
+void pps_timestamp_rebase(int32_t offset) {
+#ifdef CSR_PPS_TIMESTAMP_BASE
+    pps_ts_last       += (uint32_t)offset;
+    pps_ts_start_10s  += (uint32_t)offset;
+    pps_ts_start_100s += (uint32_t)offset;
+#else
+    (void)offset;
+#endif
+}
+
+#ifdef CSR_PPS_TIMESTAMP_BASE
+/* Returns the error of the interval between two timestamps (modulo 2^32
+   arithmetic handles the counter wrap). */
+static int32_t pps_timestamp_error(uint32_t start, uint32_t end, uint32_t target) {
+    return (int32_t)(end - start - target);
+}
+
+/* Returns true if the error magnitude exceeds the tolerance. */
+static bool pps_timestamp_out_of_tol(int32_t error, uint32_t tol) {
+    uint32_t magnitude = (error < 0) ? -(uint32_t)error : (uint32_t)error;
+    return magnitude > tol;
+}
+#endif
+
+/* PPS Timestamp ISR handler (continuous-count mode): derives the 1s error on
+   every PPS and the 10s/100s errors at the end of their windows from a
+   free-running counter, then fills the packet buffer as vctcxo_tamer_isr(). */
+__attribute__((section(".text.isr")))
+void pps_timestamp_isr(void *context) {
+#ifdef CSR_PPS_TIMESTAMP_BASE
+    struct vctcxo_tamer_pkt_buf *pkt = (struct vctcxo_tamer_pkt_buf *)context;
+    uint32_t ts = pps_timestamp_timestamp_read();
+
+#ifdef CONFIG_DAC_SLEW
+    /* DAC ramping/settling: no measurement, the windows start on the first
+       PPS once settled. */
+    if (dac_slew_busy) {
+        pps_ts_valid = false;
+        return;
+    }
+#endif
+
+    /* First PPS: start of all windows. */
+    if (!pps_ts_valid) {
+        pps_ts_valid = true;
+        pps_ts_last  = ts;
+        pps_timestamp_restart();
+        return;
+    }
+
+    /* 1s window. */
+    pkt->pps_1s_error      = pps_timestamp_error(pps_ts_last, ts, pps_timestamp_target_1s_read());
+    pkt->pps_1s_error_flag = pps_timestamp_out_of_tol(pkt->pps_1s_error, pps_timestamp_tol_1s_read());
+    pkt->pps_windows       = VT_STAT_ERR_1S;
+    pps_ts_last = ts;
+
+    /* Phase error vs local 1s epoch (captured on the same PPS edge). */
+    pkt->pps_phase_error = (int32_t)pps_timestamp_phase_read();
+
+    /* 10s window. */
+    pkt->pps_10s_error_flag = false;
+    if (++pps_ts_count_10s >= 10) {
+        pkt->pps_10s_error      = pps_timestamp_error(pps_ts_start_10s, ts, pps_timestamp_target_10s_read());
+        pkt->pps_10s_error_flag = pps_timestamp_out_of_tol(pkt->pps_10s_error, pps_timestamp_tol_10s_read());
+        pkt->pps_windows       |= VT_STAT_ERR_10S;
+        pps_ts_start_10s = ts;
+        pps_ts_count_10s = 0;
+    }
+
+    /* 100s window. */
+    pkt->pps_100s_error_flag = false;
+    if (++pps_ts_count_100s >= 100) {
+        pkt->pps_100s_error      = pps_timestamp_error(pps_ts_start_100s, ts, pps_timestamp_target_100s_read());
+        pkt->pps_100s_error_flag = pps_timestamp_out_of_tol(pkt->pps_100s_error, pps_timestamp_tol_100s_read());
+        pkt->pps_windows        |= VT_STAT_ERR_100S;
+        pps_ts_start_100s = ts;
+        pps_ts_count_100s = 0;
+    }
+
+    /* Long window. */
+    vctcxo_tamer_long_read(pkt);
+
+    /* Tell the main loop that there is a request pending. */
+    pkt->ready = true;
+#else
+    (void)context;
+#endif
+}
+
+/* Returns the tuning mode selected by the host: 10 MHz reference when
+   available and enabled, 1 PPS otherwise. */
+static vctcxo_tamer_mode vctcxo_tamer_host_mode(void) {
+#ifdef CSR_REF_TICK_BASE
+    if (ref_tick_enable_read() & 0x1) {
+        return VCTCXO_TAMER_10_MHZ;
+    }
+#endif
+    return VCTCXO_TAMER_1_PPS;
+}
+
 /* Initializes the VCTCXO Tamer. */
 void vctcxo_tamer_init(void){
     /* Default VCTCXO Tamer and its interrupts to be disabled. */
     vctcxo_tamer_write(VT_STATE_ADDR, 0x00);
-    vctcxo_tamer_set_tune_mode(VCTCXO_TAMER_1_PPS);
+    vctcxo_tamer_set_tune_mode(vctcxo_tamer_host_mode());
 }
 
 /* Disables the VCTCXO Tamer. */
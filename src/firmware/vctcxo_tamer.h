@@ -34,10 +34,32 @@
 #define VT_STAT_ERR_1S           (0x01)
 #define VT_STAT_ERR_10S          (1<<1)
 #define VT_STAT_ERR_100S         (1<<2)
+#define VT_STAT_ERR_LONG         (1<<3) /* Long window (not a Tamer register bit). */
+
+/*-----------------------------------------------------------------------*/
+/* DAC Slew                                                              */
+/*-----------------------------------------------------------------------*/
+
+/* Trim DAC slew (CONFIG_DAC_SLEW): tick period, settle interval before the
+   measurements restart (ms) and fixed step (DAC counts per tick, unless
+   CONFIG_DAC_SLEW_SHIFT selects the exponential slew). */
+#ifndef CONFIG_DAC_SLEW_TICK_MS
+#define CONFIG_DAC_SLEW_TICK_MS   10
+#endif
+#ifndef CONFIG_DAC_SLEW_SETTLE_MS
+#define CONFIG_DAC_SLEW_SETTLE_MS 100
+#endif
+#ifndef CONFIG_DAC_SLEW_STEP
+#define CONFIG_DAC_SLEW_STEP      256
+#endif
+#define DAC_SLEW_SETTLE_TICKS     (CONFIG_DAC_SLEW_SETTLE_MS / CONFIG_DAC_SLEW_TICK_MS)
 
 /* Cached version of the VCTCXO Tamer control register. */
 extern uint8_t vctcxo_tamer_ctrl_reg;
 
+/* Current tuning mode (vctcxo_tamer_mode), selected on vctcxo_tamer_init(). */
+extern uint8_t vctcxo_tamer_tune_mode;
+
 /* Global variable containing the current VCTCXO DAC setting. This is a 'cached'
    value of what is written to the DAC and is used by the VCTCXO calibration
    algorithm to avoid constant read requests going out to the DAC. Initial
@@ -45,6 +67,15 @@ extern uint8_t vctcxo_tamer_ctrl_reg;
  */
 extern uint16_t vctcxo_trim_dac_value;
 
+/* Fractional part of the trim DAC setting in 1/2^DAC_FRAC_BITS DAC counts,
+   sigma-delta modulated on the DAC output by the DAC dither (0 without). */
+#ifdef CSR_DAC_DITHER_BASE
+#define DAC_FRAC_BITS CONFIG_DAC_FRAC_BITS
+#else
+#define DAC_FRAC_BITS 0
+#endif
+extern uint16_t vctcxo_trim_dac_frac;
+
 /* Structure that represents a point on a line. Used for calibrating the
    VCTCXO.
  */
@@ -53,18 +84,153 @@ typedef struct point {
     uint16_t y; /* DAC count. */
 } point_t;
 
+/* Slope of the calibration line in DAC counts per error count. When built with
+   CONFIG_FIXED_POINT the slope is held as a signed Q16.16 value so that the
+   calibration and fine tune paths are integer-only (no soft-float/libm).
+ */
+#ifdef CONFIG_FIXED_POINT
+#define SLOPE_FRAC_BITS 16
+typedef int32_t slope_t;
+#else
+typedef float slope_t;
+#endif
+
 typedef struct line {
     point_t  point[2];
-    float  slope;
+    slope_t  slope;
     uint16_t y_intercept; /* In DAC counts. */
 } line_t;
 
+/* State of the FINE_TUNE digital PI (type-2 PLL) loop. */
+typedef struct pi_loop {
+    int32_t phase; /* Phase error, in counts (accumulated 1s error or measured). */
+} pi_loop_t;
+
+/* Calibration slope pre-scaled for the 10s/100s windows of the FINE_TUNE
+   proportional loop (no division on the DAC update path). */
+typedef struct window_slopes {
+    slope_t slope_10s;
+    slope_t slope_100s;
+} window_slopes_t;
+
+/* State of the FINE_TUNE adaptive interval loop: the 1s errors are summed
+   over windows of 4^level seconds and the window length is chosen from the
+   running 1s error variance. */
+typedef struct adaptive {
+    uint8_t  level;       /* Window length: 4^level seconds. */
+    uint16_t count;       /* Number of samples in the current window. */
+    int32_t  sum;         /* Sum of the 1s errors in the current window. */
+    int32_t  last;        /* Last 1s error. */
+    bool     last_valid;  /* Last 1s error valid (not right after a DAC update). */
+    int64_t  var;         /* Running 2-sample variance of the 1s error (Q8). */
+} adaptive_t;
+
+/* State of the secant/bisection COARSE_TUNE_SEARCH. The calibration line
+   points hold the last two measurements; neg/pos bracket the zero error
+   once measurements of both signs have been seen; lo/hi are the
+   measurements at the lowest/highest DAC values (the widest-spaced pair,
+   giving the FINE_TUNE slope); settle counts the 1s errors summed in
+   settle_sum at the converged DAC value. */
+typedef struct coarse_search {
+    uint8_t  iter;
+    uint8_t  settle;
+    bool     neg_valid;
+    bool     pos_valid;
+    point_t  neg;
+    point_t  pos;
+    point_t  lo;
+    point_t  hi;
+    int32_t  settle_sum;
+} coarse_search_t;
+
+/* Holdover drift model: the DAC value is averaged over fixed windows of
+   FINE_TUNE samples and the drift is the filtered difference between
+   consecutive window averages. Values are fixed-point (Q16). */
+#ifdef CONFIG_HOLDOVER
+typedef struct holdover {
+    uint32_t sum;         /* Sum of DAC values in the current window. */
+    uint16_t count;       /* Number of samples in the current window. */
+    bool     avg_valid;
+    bool     drift_valid;
+    int64_t  avg;         /* Last window average (DAC counts, Q16). */
+    int32_t  drift;       /* Drift estimate (DAC counts/sample, Q16). */
+    int64_t  dac;         /* Holdover DAC value (DAC counts, Q16). */
+} holdover_t;
+#endif
+
+/* Outlier filter: last 1s error samples (circular, CONFIG_OUTLIER_WINDOW
+   samples, up to 9). */
+#define OUTLIER_WINDOW_MAX 9
+#ifdef CONFIG_OUTLIER_WINDOW
+typedef struct outlier_filter {
+    int32_t  sample[CONFIG_OUTLIER_WINDOW];
+    uint8_t  count;       /* Number of valid samples. */
+    uint8_t  pos;         /* Next sample position. */
+    uint32_t rejected;    /* Number of rejected samples. */
+} outlier_filter_t;
+#endif
+
+/* Temperature compensation table: trim DAC value learned at temperature
+   nodes spaced 2^CONFIG_TEMP_COMP_SHIFT (1/16 C) apart, linearly
+   interpolated (up to 16 nodes, 34 bytes of SRAM). */
+#define TEMP_COMP_NODES 16
+typedef struct temp_comp {
+    uint16_t node[TEMP_COMP_NODES]; /* Learned trim DAC value at each node. */
+    uint16_t valid;                 /* Node valid mask. */
+    bool     ref_valid;
+    int32_t  ref;                   /* Table value the DAC is steered from (DAC counts, Q4). */
+} temp_comp_t;
+
+/* Lock quality: exponentially weighted (2^CONFIG_LOCK_QUALITY_SHIFT
+   samples) mean, mean square and decaying peak of the error of one
+   measurement interval (error counts, Q8). */
+typedef struct lock_stats {
+    int64_t  msq;         /* Mean square error (Q8, < 0: no sample yet). */
+    int32_t  mean;        /* Mean error (Q8). */
+    int32_t  peak;        /* Decaying max |error| (Q8). */
+} lock_stats_t;
+
+/* Lock quality of the 1s/10s/100s intervals and lock decision (hysteresis
+   on the 1s RMS error). */
+typedef struct lock_quality {
+    lock_stats_t interval[3];
+    uint16_t     count;     /* 1s samples since reset (up to the window). */
+    bool         locked;
+    uint8_t      ticks;     /* Samples into the current lock second (10 MHz reference). */
+    uint32_t     lock_time; /* Seconds since lock. */
+} lock_quality_t;
+
+/* PPS source voting: per-source 1s error (from the PPS Select timestamps)
+   and score, the filtered magnitude of the 1s error change (the VCTCXO
+   frequency error, common to all sources and slowly varying, cancels out:
+   the score is the source PPS jitter). CONFIG_PPS_INPUTS sources, up to 4. */
+#define PPS_SOURCES_MAX 4
+typedef struct pps_source {
+    bool     valid;       /* Last timestamp valid. */
+    bool     fresh;       /* 1s error updated on the last vote. */
+    uint8_t  count;       /* PPS edge count of the last timestamp. */
+    uint8_t  samples;     /* Score samples (up to the score window). */
+    uint32_t last;        /* Last timestamp (RF clock counts). */
+    int32_t  error;       /* Last 1s error (counts). */
+    uint32_t score;       /* Filtered |1s error change| (counts, Q8). */
+} pps_source_t;
+
+#ifdef CONFIG_PPS_INPUTS
+typedef struct pps_vote {
+    pps_source_t source[CONFIG_PPS_INPUTS];
+    uint32_t     switches;
+    uint8_t      sel;     /* Selected source. */
+} pps_vote_t;
+#endif
+
 /* State machine for VCTCXO tuning. */
 typedef enum state {
     COARSE_TUNE_MIN,
     COARSE_TUNE_MAX,
     COARSE_TUNE_DONE,
+    COARSE_TUNE_SEARCH,
     FINE_TUNE,
+    HOLDOVER,
     DO_NOTHING
 } state_t;
 
@@ -82,14 +248,20 @@ typedef enum {
     VCTCXO_TAMER_10_MHZ = 2
 } vctcxo_tamer_mode;
 
+/* Errors first, then flags (no padding between them: SRAM). */
 struct vctcxo_tamer_pkt_buf {
-    volatile bool    ready;
     volatile int32_t pps_1s_error;
-    volatile bool    pps_1s_error_flag;
     volatile int32_t pps_10s_error;
-    volatile bool    pps_10s_error_flag;
     volatile int32_t pps_100s_error;
+    volatile int32_t pps_long_error;
+    volatile int32_t pps_phase_error; /* Continuous-count mode only. */
+    volatile bool    ready;
+    volatile bool    pps_1s_error_flag;
+    volatile bool    pps_10s_error_flag;
     volatile bool    pps_100s_error_flag;
+    volatile bool    pps_long_error_flag;
+    volatile bool    pps_long_ready;  /* Long window out of tolerance, not processed yet. */
+    volatile uint8_t pps_windows;     /* Windows completed on this PPS (VT_STAT_ERR_* bits), continuous-count mode only. */
 };
 
 /*-----------------------------------------------------------------------*/
@@ -112,10 +284,30 @@ int32_t vctcxo_tamer_read_count(uint8_t addr);
 
 void vctcxo_trim_dac_write(uint16_t val);
 
+void vctcxo_trim_dac_write_frac(uint32_t val);
+
+void vctcxo_trim_dac_slew_tick(void);
+
+bool vctcxo_trim_dac_slew_busy(void);
+
 void vctcxo_tamer_isr(void *context);
 
 void vctcxo_tamer_init(void);
 
 void vctcxo_tamer_dis(void);
 
+uint16_t vctcxo_tamer_long_len(void);
+
+void vctcxo_tamer_long_isr(void *context);
+
+void pps_timestamp_reset(void);
+
+void pps_timestamp_restart(void);
+
+void pps_timestamp_realign(void);
+
+void pps_timestamp_rebase(int32_t offset);
+
+void pps_timestamp_isr(void *context);
+
 #endif /* VCTCXO_TAMER_H_ */
@@ -28,16 +28,49 @@ ppsdo_config_layout = [
     ("ten_s_tol",       32, DIR_M_TO_S),  # Tolerance for 10-second interval.
     ("hundred_s_target",32, DIR_M_TO_S),  # Target value for 100-second interval.
     ("hundred_s_tol",   32, DIR_M_TO_S),  # Tolerance for 100-second interval.
+    ("long_len",        16, DIR_M_TO_S),  # Length of the long interval in seconds (0: disabled).
+    ("long_target",     32, DIR_M_TO_S),  # Target value for long interval (modulo 2^32).
+    ("long_tol",        32, DIR_M_TO_S),  # Tolerance for long interval.
+    ("temp",            16, DIR_M_TO_S),  # Temperature (signed, 1/16 C, 0x8000: not available).
+    ("warm_start",       1, DIR_M_TO_S),  # Warm start enable (skip coarse tune).
+    ("warm_slope",      32, DIR_M_TO_S),  # Warm start calibration slope (Q16.16).
+    ("warm_dac",        16, DIR_M_TO_S),  # Warm start DAC value.
+    ("lock_tol",        32, DIR_M_TO_S),  # Lock threshold on the 1s RMS error (counts, Q8, 0: 1s tolerance).
+    ("ref_enable",       1, DIR_M_TO_S),  # 10 MHz reference mode (targets/tolerances per reference tick).
+    ("gen",              8, DIR_M_TO_S),  # Config generation: change to apply new targets/tolerances at the next PPS.
 ]
 
 ppsdo_status_layout = [
     ("one_s_error",      32, DIR_M_TO_S),  # Error value for 1-second interval.
     ("ten_s_error",      32, DIR_M_TO_S),  # Error value for 10-second interval.
     ("hundred_s_error",  32, DIR_M_TO_S),  # Error value for 100-second interval.
+    ("long_error",       32, DIR_M_TO_S),  # Error value for long interval (0: without long window).
     ("dac_tuned_val",    16, DIR_M_TO_S),  # DAC tuned value.
     ("accuracy",          4, DIR_M_TO_S),  # Accuracy status.
     ("pps_active",        1, DIR_M_TO_S),  # PPS active status.
     ("state",             4, DIR_M_TO_S),  # Current state.
+    ("slope",            32, DIR_M_TO_S),  # Calibration slope (Q16.16, 0: without calibration).
+    ("phase_error",      32, DIR_M_TO_S),  # PPS phase error (signed, RF clock cycles).
+    ("rejected",         32, DIR_M_TO_S),  # Number of PPS error samples rejected as outliers.
+    ("one_s_mean",       32, DIR_M_TO_S),  # 1s error mean (signed, counts, Q8).
+    ("one_s_rms",        32, DIR_M_TO_S),  # 1s error RMS (counts, Q8).
+    ("one_s_max",        32, DIR_M_TO_S),  # 1s error decaying max |error| (counts, Q8).
+    ("ten_s_mean",       32, DIR_M_TO_S),  # 10s error mean (signed, counts, Q8).
+    ("ten_s_rms",        32, DIR_M_TO_S),  # 10s error RMS (counts, Q8).
+    ("ten_s_max",        32, DIR_M_TO_S),  # 10s error decaying max |error| (counts, Q8).
+    ("hundred_s_mean",   32, DIR_M_TO_S),  # 100s error mean (signed, counts, Q8).
+    ("hundred_s_rms",    32, DIR_M_TO_S),  # 100s error RMS (counts, Q8).
+    ("hundred_s_max",    32, DIR_M_TO_S),  # 100s error decaying max |error| (counts, Q8).
+    ("locked",            1, DIR_M_TO_S),  # Locked (hysteresis on the 1s RMS error).
+    ("lock_time",        32, DIR_M_TO_S),  # Time since lock (seconds).
+    ("pps_source",        2, DIR_M_TO_S),  # Selected PPS source.
+    ("pps_sources_active",4, DIR_M_TO_S),  # PPS active status of each source.
+]
+
+ppsdo_history_layout = [
+    ("rd_addr",          16, DIR_M_TO_S),  # History read address (sample index % depth).
+    ("rd_data",          64, DIR_M_TO_S),  # History read data.
+    ("seq",              32, DIR_M_TO_S),  # History sequence counter (samples written, 0: without history).
 ]
 
 # PPSDO --------------------------------------------------------------------------------------------
@@ -47,8 +80,13 @@ class PPSDO(LiteXModule):
         # Control.
         self.enable = Signal()
 
-        # PPS.
-        self.pps    = Signal()
+        # PPS (up to 4 sources, the first pps_inputs ones of add_sources are connected).
+        self.pps        = Signal(4)
+        self.pps_inputs = 1
+
+        # 10 MHz Reference (core port only with ref_10mhz of add_sources).
+        self.ref_clk   = Signal()
+        self.ref_10mhz = False
 
         # UART.
         self.uart   = Record(ppsdo_uart_layout)
@@ -59,15 +97,18 @@ class PPSDO(LiteXModule):
         # Status.
         self.status = Record(ppsdo_status_layout)
 
+        # History.
+        self.history = Record(ppsdo_history_layout)
+
         # CSRs.
         if with_csr:
             self.add_csr()
 
         # # #
 
-        # Instance.
-        # ---------
-        self.specials += Instance("ppsdo",
+        # Instance Parameters (instantiated on finalize, once add_sources set pps_inputs/ref_10mhz).
+        # --------------------------------------------------------------------------------
+        self.ppsdo_params = dict(
             # Sys Clk/Rst.
             i_sys_clk              = ClockSignal(cd_sys),
             i_sys_rst              = ResetSignal(cd_sys),
@@ -79,9 +120,6 @@ class PPSDO(LiteXModule):
             # Control.
             i_enable               = self.enable,
 
-            # PPS.
-            i_pps                  = self.pps,
-
             # UART.
             i_uart_rx              = self.uart.rx,
             o_uart_tx              = self.uart.tx,
@@ -93,15 +131,60 @@ class PPSDO(LiteXModule):
             i_config_10s_tol       = self.config.ten_s_tol,
             i_config_100s_target   = self.config.hundred_s_target,
             i_config_100s_tol      = self.config.hundred_s_tol,
+            i_config_long_len      = self.config.long_len,
+            i_config_long_target   = self.config.long_target,
+            i_config_long_tol      = self.config.long_tol,
+            i_config_temp          = self.config.temp,
+            i_config_warm_start    = self.config.warm_start,
+            i_config_warm_slope    = self.config.warm_slope,
+            i_config_warm_dac      = self.config.warm_dac,
+            i_config_lock_tol      = self.config.lock_tol,
+            i_config_ref_enable    = self.config.ref_enable,
+            i_config_gen           = self.config.gen,
 
             # Core Status.
             o_status_1s_error      = self.status.one_s_error,
             o_status_10s_error     = self.status.ten_s_error,
             o_status_100s_error    = self.status.hundred_s_error,
+            o_status_long_error    = self.status.long_error,
             o_status_dac_tuned_val = self.status.dac_tuned_val,
             o_status_accuracy      = self.status.accuracy,
             o_status_pps_active    = self.status.pps_active,
             o_status_state         = self.status.state,
+            o_status_slope         = self.status.slope,
+            o_status_phase_error   = self.status.phase_error,
+            o_status_rejected      = self.status.rejected,
+            o_status_1s_mean       = self.status.one_s_mean,
+            o_status_1s_rms        = self.status.one_s_rms,
+            o_status_1s_max        = self.status.one_s_max,
+            o_status_10s_mean      = self.status.ten_s_mean,
+            o_status_10s_rms       = self.status.ten_s_rms,
+            o_status_10s_max       = self.status.ten_s_max,
+            o_status_100s_mean     = self.status.hundred_s_mean,
+            o_status_100s_rms      = self.status.hundred_s_rms,
+            o_status_100s_max      = self.status.hundred_s_max,
+            o_status_locked        = self.status.locked,
+            o_status_lock_time     = self.status.lock_time,
+            o_status_pps_source    = self.status.pps_source,
+            o_status_pps_sources_active = self.status.pps_sources_active,
+
+            # History.
+            i_history_rd_addr      = self.history.rd_addr,
+            o_history_rd_data      = self.history.rd_data,
+            o_history_seq          = self.history.seq,
+        )
+
+    def do_finalize(self):
+        # 10 MHz Reference Clk.
+        if self.ref_10mhz:
+            self.ppsdo_params.update(i_ref_clk=self.ref_clk)
+
+        # Instance.
+        # ---------
+        self.specials += Instance("ppsdo",
+            # PPS.
+            i_pps = self.pps[:self.pps_inputs],
+            **self.ppsdo_params
         )
 
     def add_csr(self):
@@ -118,6 +201,16 @@ class PPSDO(LiteXModule):
         self._config_ten_s_tol        = CSRStorage(32, description="Tolerance for 10-second interval.")
         self._config_hundred_s_target = CSRStorage(32, description="Target value for 100-second interval.")
         self._config_hundred_s_tol    = CSRStorage(32, description="Tolerance for 100-second interval.")
+        self._config_long_len         = CSRStorage(16, description="Length of the long interval in seconds (0: disabled).")
+        self._config_long_target      = CSRStorage(32, description="Target value for long interval (modulo 2^32).")
+        self._config_long_tol         = CSRStorage(32, description="Tolerance for long interval.")
+        self._config_temp             = CSRStorage(16, reset=0x8000, description="Temperature (signed, 1/16 C, 0x8000: not available).")
+        self._config_warm_start       = CSRStorage(1,  description="Warm start enable (skip coarse tune).")
+        self._config_warm_slope       = CSRStorage(32, description="Warm start calibration slope (Q16.16).")
+        self._config_warm_dac         = CSRStorage(16, description="Warm start DAC value.")
+        self._config_lock_tol         = CSRStorage(32, description="Lock threshold on the 1s RMS error (counts, Q8, 0: 1s tolerance).")
+        self._config_ref_enable       = CSRStorage(1,  description="10 MHz reference mode (targets/tolerances per reference tick).")
+        self._config_gen              = CSRStorage(8,  description="Config generation: change to apply new targets/tolerances at the next PPS.")
         self.comb += [
             self.config.one_s_target    .eq(self._config_one_s_target.storage),
             self.config.one_s_tol       .eq(self._config_one_s_tol.storage),
@@ -125,33 +218,134 @@ class PPSDO(LiteXModule):
             self.config.ten_s_tol       .eq(self._config_ten_s_tol.storage),
             self.config.hundred_s_target.eq(self._config_hundred_s_target.storage),
             self.config.hundred_s_tol   .eq(self._config_hundred_s_tol.storage),
+            self.config.long_len        .eq(self._config_long_len.storage),
+            self.config.long_target     .eq(self._config_long_target.storage),
+            self.config.long_tol        .eq(self._config_long_tol.storage),
+            self.config.temp            .eq(self._config_temp.storage),
+            self.config.warm_start      .eq(self._config_warm_start.storage),
+            self.config.warm_slope      .eq(self._config_warm_slope.storage),
+            self.config.warm_dac        .eq(self._config_warm_dac.storage),
+            self.config.lock_tol        .eq(self._config_lock_tol.storage),
+            self.config.ref_enable      .eq(self._config_ref_enable.storage),
+            self.config.gen             .eq(self._config_gen.storage),
         ]
 
         # Status.
         self._status_one_s_error     = CSRStatus(32, description="Error value for 1-second interval.")
         self._status_ten_s_error     = CSRStatus(32, description="Error value for 10-second interval.")
         self._status_hundred_s_error = CSRStatus(32, description="Error value for 100-second interval.")
+        self._status_long_error      = CSRStatus(32, description="Error value for long interval.")
         self._status_dac_tuned_val   = CSRStatus(16, description="DAC tuned value.")
         self._status_accuracy        = CSRStatus(4,  description="Accuracy status.")
         self._status_pps_active      = CSRStatus(1,  description="PPS active status.")
         self._status_state           = CSRStatus(4,  description="Current state.")
+        self._status_slope           = CSRStatus(32, description="Calibration slope (Q16.16).")
+        self._status_phase_error     = CSRStatus(32, description="PPS phase error (signed, RF clock cycles).")
+        self._status_rejected        = CSRStatus(32, description="Number of PPS error samples rejected as outliers.")
+        self._status_one_s_mean      = CSRStatus(32, description="1s error mean (signed, counts, Q8).")
+        self._status_one_s_rms       = CSRStatus(32, description="1s error RMS (counts, Q8).")
+        self._status_one_s_max       = CSRStatus(32, description="1s error decaying max |error| (counts, Q8).")
+        self._status_ten_s_mean      = CSRStatus(32, description="10s error mean (signed, counts, Q8).")
+        self._status_ten_s_rms       = CSRStatus(32, description="10s error RMS (counts, Q8).")
+        self._status_ten_s_max       = CSRStatus(32, description="10s error decaying max |error| (counts, Q8).")
+        self._status_hundred_s_mean  = CSRStatus(32, description="100s error mean (signed, counts, Q8).")
+        self._status_hundred_s_rms   = CSRStatus(32, description="100s error RMS (counts, Q8).")
+        self._status_hundred_s_max   = CSRStatus(32, description="100s error decaying max |error| (counts, Q8).")
+        self._status_locked          = CSRStatus(1,  description="Locked (hysteresis on the 1s RMS error).")
+        self._status_lock_time       = CSRStatus(32, description="Time since lock (seconds).")
+        self._status_pps_source      = CSRStatus(2,  description="Selected PPS source.")
+        self._status_pps_sources_active = CSRStatus(4, description="PPS active status of each source.")
         self.comb += [
             self._status_one_s_error.status    .eq(self.status.one_s_error),
             self._status_ten_s_error.status    .eq(self.status.ten_s_error),
             self._status_hundred_s_error.status.eq(self.status.hundred_s_error),
+            self._status_long_error.status     .eq(self.status.long_error),
             self._status_dac_tuned_val.status  .eq(self.status.dac_tuned_val),
             self._status_accuracy.status       .eq(self.status.accuracy),
             self._status_pps_active.status     .eq(self.status.pps_active),
             self._status_state.status          .eq(self.status.state),
+            self._status_slope.status          .eq(self.status.slope),
+            self._status_phase_error.status    .eq(self.status.phase_error),
+            self._status_rejected.status       .eq(self.status.rejected),
+            self._status_one_s_mean.status     .eq(self.status.one_s_mean),
+            self._status_one_s_rms.status      .eq(self.status.one_s_rms),
+            self._status_one_s_max.status      .eq(self.status.one_s_max),
+            self._status_ten_s_mean.status     .eq(self.status.ten_s_mean),
+            self._status_ten_s_rms.status      .eq(self.status.ten_s_rms),
+            self._status_ten_s_max.status      .eq(self.status.ten_s_max),
+            self._status_hundred_s_mean.status .eq(self.status.hundred_s_mean),
+            self._status_hundred_s_rms.status  .eq(self.status.hundred_s_rms),
+            self._status_hundred_s_max.status  .eq(self.status.hundred_s_max),
+            self._status_locked.status         .eq(self.status.locked),
+            self._status_lock_time.status      .eq(self.status.lock_time),
+            self._status_pps_source.status     .eq(self.status.pps_source),
+            self._status_pps_sources_active.status.eq(self.status.pps_sources_active),
         ]
 
-    def add_sources(self, dac_bits=16):
+        # History.
+        # Burst readout: write the start address then read data_lo/data_hi pairs, the address is
+        # incremented on each data_hi read.
+        self._history_seq     = CSRStatus(32, description="History sequence counter (samples written).")
+        self._history_addr    = CSRStorage(16, description="History read address (auto-incremented).")
+        self._history_data_lo = CSRStatus(32, description="History sample [31:0]: 1s error.")
+        self._history_data_hi = CSRStatus(32, description="History sample [63:32]: DAC [15:0], state [19:16], flags [23:20], sequence [31:24].")
+        self.comb += [
+            self._history_seq.status    .eq(self.history.seq),
+            self._history_data_lo.status.eq(self.history.rd_data[:32]),
+            self._history_data_hi.status.eq(self.history.rd_data[32:]),
+        ]
+        self.sync += [
+            If(self._history_addr.re,
+                self.history.rd_addr.eq(self._history_addr.storage)
+            ).Elif(self._history_data_hi.we,
+                self.history.rd_addr.eq(self.history.rd_addr + 1)
+            )
+        ]
+
+    def add_sources(self, dac_bits=16, fixed_point=False, coarse_tune="minmax",
+        fine_tune="proportional", pi_kp_shift=2, pi_ki_shift=6, history_depth=64, continuous=False,
+        outlier_window=0, outlier_floor=64, adaptive_max_level=5,
+        temp_comp=False, temp_comp_min=-40, temp_comp_step=8, with_profiler=False,
+        telemetry=False, size_opt=False, with_cycle_counter=False, dac_slew="none", dac_slew_step=256,
+        dac_slew_shift=2, dac_slew_tick_ms=10, dac_settle_ms=100, dac_frac_bits=0, dac_dither_freq=1e3,
+        lock_quality=False, lock_quality_shift=6, pps_inputs=1, ref_10mhz=False, ref_rate=10,
+        config_update=False, with_calibration=False, with_history=False, with_snapshot=False,
+        with_long_window=False, with_holdover=False, rom_size=0x2000, sram_size=0x100):
         from litex.gen import LiteXContext
         cdir = os.path.abspath(os.path.dirname(__file__))
 
+        # PPS inputs and 10 MHz reference of the core (connected on finalize).
+        self.pps_inputs = pps_inputs
+        self.ref_10mhz  = ref_10mhz
+
         # Generate Core.
         # --------------
-        ret = os.system(f"cd {cdir} && python3 ppsdo_gen.py --sys-clk-freq={LiteXContext.top.sys_clk_freq} --dac-bits={dac_bits}")
+        gen_args  = f"--sys-clk-freq={LiteXContext.top.sys_clk_freq} --dac-bits={dac_bits}"
+        gen_args += " --fixed-point" if fixed_point else ""
+        gen_args += f" --coarse-tune={coarse_tune}"
+        gen_args += f" --fine-tune={fine_tune} --pi-kp-shift={pi_kp_shift} --pi-ki-shift={pi_ki_shift}"
+        gen_args += f" --adaptive-max-level={adaptive_max_level}"
+        gen_args += f" --with-history --history-depth={history_depth}" if with_history else ""
+        gen_args += " --continuous" if continuous else ""
+        gen_args += f" --lock-quality --lock-quality-shift={lock_quality_shift}" if lock_quality else ""
+        gen_args += f" --pps-inputs={pps_inputs}"
+        gen_args += f" --ref-10mhz --ref-rate={ref_rate}" if ref_10mhz else ""
+        gen_args += " --config-update" if config_update else ""
+        gen_args += f" --outlier-window={outlier_window} --outlier-floor={outlier_floor}"
+        gen_args += f" --temp-comp --temp-comp-min={temp_comp_min} --temp-comp-step={temp_comp_step}" if temp_comp else ""
+        gen_args += " --with-profiler" if with_profiler else ""
+        gen_args += " --with-cycle-counter" if with_cycle_counter else ""
+        gen_args += " --with-calibration"   if with_calibration   else ""
+        gen_args += " --with-snapshot"      if with_snapshot      else ""
+        gen_args += " --with-long-window"   if with_long_window   else ""
+        gen_args += " --with-holdover"      if with_holdover      else ""
+        gen_args += f" --dac-slew={dac_slew} --dac-slew-step={dac_slew_step} --dac-slew-shift={dac_slew_shift}"
+        gen_args += f" --dac-slew-tick-ms={dac_slew_tick_ms} --dac-settle-ms={dac_settle_ms}"
+        gen_args += f" --dac-frac-bits={dac_frac_bits} --dac-dither-freq={dac_dither_freq}"
+        gen_args += " --telemetry"     if telemetry     else ""
+        gen_args += " --size-opt"      if size_opt      else ""
+        gen_args += f" --rom-size={rom_size:#x} --sram-size={sram_size:#x}"
+        ret = os.system(f"cd {cdir} && python3 ppsdo_gen.py {gen_args}")
         if ret != 0:
             raise RuntimeError(f"PPSDO generation failed.")
 
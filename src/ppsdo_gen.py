@@ -17,11 +17,16 @@ sys.path.append("../../")
 
 from migen import *
 
+from migen.genlib.cdc import MultiReg, PulseSynchronizer
+
 from litex.gen import *
 
 from litex.build.generic_platform  import *
 from litex.build.generic_toolchain import *
 
+from litex.soc.interconnect.csr import *
+from litex.soc.interconnect.csr_eventmanager import *
+
 from litex.soc.integration.soc import SoCRegion
 from litex.soc.integration.soc_core import *
 from litex.soc.integration.builder import *
@@ -31,7 +36,7 @@ from LimeDFB.vctcxo_tamer.src.vctcxo_tamer import VCTCXOTamer
 
 # IOs/Interfaces -----------------------------------------------------------------------------------
 
-def get_common_ios():
+def get_common_ios(pps_inputs=1):
     return [
         # Sys Clk/Rst.
         ("sys_clk", 0, Pins(1)),
@@ -41,6 +46,9 @@ def get_common_ios():
         ("rf_clk", 0, Pins(1)),
         ("rf_rst", 0, Pins(1)),
 
+        # 10 MHz Reference Clk.
+        ("ref_clk", 0, Pins(1)),
+
         # UART.
         ("uart", 0,
             Subsignal("tx", Pins(1)),
@@ -51,7 +59,7 @@ def get_common_ios():
         ("enable", 0, Pins(1)),
 
         # PPS.
-        ("pps", 0, Pins(1)),
+        ("pps", 0, Pins(pps_inputs)),
 
         # Config Inputs.
         ("config_1s_target",   0, Pins(32)),
@@ -60,22 +68,54 @@ def get_common_ios():
         ("config_10s_tol",     0, Pins(32)),
         ("config_100s_target", 0, Pins(32)),
         ("config_100s_tol",    0, Pins(32)),
+        ("config_long_len",    0, Pins(16)),
+        ("config_long_target", 0, Pins(32)),
+        ("config_long_tol",    0, Pins(32)),
+        ("config_temp",        0, Pins(16)),
+        ("config_warm_start",  0, Pins(1)),
+        ("config_warm_slope",  0, Pins(32)),
+        ("config_warm_dac",    0, Pins(16)),
+        ("config_lock_tol",    0, Pins(32)),
+        ("config_ref_enable",  0, Pins(1)),
+        ("config_gen",         0, Pins(8)),
 
         # Status Outputs.
         ("status_1s_error",      0, Pins(32)),
         ("status_10s_error",     0, Pins(32)),
         ("status_100s_error",    0, Pins(32)),
+        ("status_long_error",    0, Pins(32)),
         ("status_dac_tuned_val", 0, Pins(16)),
         ("status_accuracy",      0, Pins(8)),
         ("status_state",         0, Pins(8)),
         ("status_pps_active",    0, Pins(1)),
+        ("status_slope",         0, Pins(32)),
+        ("status_phase_error",   0, Pins(32)),
+        ("status_rejected",      0, Pins(32)),
+        ("status_1s_mean",       0, Pins(32)),
+        ("status_1s_rms",        0, Pins(32)),
+        ("status_1s_max",        0, Pins(32)),
+        ("status_10s_mean",      0, Pins(32)),
+        ("status_10s_rms",       0, Pins(32)),
+        ("status_10s_max",       0, Pins(32)),
+        ("status_100s_mean",     0, Pins(32)),
+        ("status_100s_rms",      0, Pins(32)),
+        ("status_100s_max",      0, Pins(32)),
+        ("status_locked",        0, Pins(1)),
+        ("status_lock_time",     0, Pins(32)),
+        ("status_pps_source",    0, Pins(2)),
+        ("status_pps_sources_active", 0, Pins(4)),
+
+        # History.
+        ("history_rd_addr", 0, Pins(16)),
+        ("history_rd_data", 0, Pins(64)),
+        ("history_seq",     0, Pins(32)),
     ]
 
 # Platform -----------------------------------------------------------------------------------------
 
 class Platform(GenericPlatform):
-    def __init__(self):
-        super().__init__(device="", io=get_common_ios())
+    def __init__(self, pps_inputs=1):
+        super().__init__(device="", io=get_common_ios(pps_inputs))
         self.toolchain._support_mixed_language = False
 
     def build(self, fragment, build_dir, build_name, **kwargs):
@@ -88,7 +128,7 @@ class Platform(GenericPlatform):
 # CRG ----------------------------------------------------------------------------------------------
 
 class _CRG(LiteXModule):
-    def __init__(self, platform):
+    def __init__(self, platform, with_ref=False):
         self.cd_sys = ClockDomain()
         self.cd_rf  = ClockDomain()
 
@@ -106,28 +146,638 @@ class _CRG(LiteXModule):
             self.cd_rf.rst.eq(rf_rst),
         ]
 
+        # 10 MHz reference (free-running, may be absent: no reset).
+        if with_ref:
+            ref_clk     = platform.request("ref_clk")
+            self.cd_ref = ClockDomain(reset_less=True)
+            self.comb += self.cd_ref.clk.eq(ref_clk)
+
+# VCTCXO Tamer Snapshot ----------------------------------------------------------------------------
+
+class _VCTCXOTamerSnapshot(LiteXModule):
+    def __init__(self, irq, err_1s, err_10s, err_100s):
+        self._err_1s   = CSRStatus(32, description="1s error latched on VCTCXO Tamer IRQ.")
+        self._err_10s  = CSRStatus(32, description="10s error latched on VCTCXO Tamer IRQ.")
+        self._err_100s = CSRStatus(32, description="100s error latched on VCTCXO Tamer IRQ.")
+
+        # # #
+
+        # Latch all errors on the IRQ rising edge so that the firmware gets a coherent snapshot with
+        # single word reads while the Tamer counters keep running.
+        irq_d = Signal()
+        self.sync += [
+            irq_d.eq(irq),
+            If(irq & ~irq_d,
+                self._err_1s.status.eq(err_1s),
+                self._err_10s.status.eq(err_10s),
+                self._err_100s.status.eq(err_100s),
+            )
+        ]
+
+# PPS Timestamp ------------------------------------------------------------------------------------
+
+class _PPSTimestamp(LiteXModule):
+    def __init__(self, pps, config, cd_rf="rf"):
+        self.phase_error  = Signal((32, True))
+
+        self._timestamp   = CSRStatus(32, description="RF clock count captured on the last PPS rising edge.")
+        self._phase       = CSRStatus(32, description="PPS phase error vs local 1s epoch (signed, RF clock cycles).")
+        self._realign     = CSRStorage(description="Write to realign the local 1s epoch on the next PPS.")
+        self._target_1s   = CSRStatus(32, description="Target value for 1-second interval.")
+        self._tol_1s      = CSRStatus(32, description="Tolerance for 1-second interval.")
+        self._target_10s  = CSRStatus(32, description="Target value for 10-second interval.")
+        self._tol_10s     = CSRStatus(32, description="Tolerance for 10-second interval.")
+        self._target_100s = CSRStatus(32, description="Target value for 100-second interval.")
+        self._tol_100s    = CSRStatus(32, description="Tolerance for 100-second interval.")
+
+        self.ev = EventManager()
+        self.ev.pps = EventSourcePulse(description="New PPS timestamp.")
+        self.ev.finalize()
+
+        # # #
+
+        # Free-running RF clock counter captured on PPS rising edges: the counter is never reset
+        # so consecutive timestamps give contiguous measurement intervals (no dead time).
+        pps_rf   = Signal()
+        pps_rf_d = Signal()
+        count    = Signal(32)
+        capture  = Signal(32)
+        toggle   = Signal()
+        self.specials += MultiReg(pps, pps_rf, odomain=cd_rf)
+        sync_rf = getattr(self.sync, cd_rf)
+        sync_rf += [
+            count.eq(count + 1),
+            pps_rf_d.eq(pps_rf),
+            If(pps_rf & ~pps_rf_d,
+                capture.eq(count),
+                toggle.eq(~toggle),
+            )
+        ]
+
+        # Local 1s epoch: RF clock cycles counted modulo the 1s target. Its value on the PPS edge is
+        # the phase (time-interval) error of the disciplined clock vs PPS, in whole RF clock cycles.
+        # A realign request restarts the epoch on the next PPS edge (phase error of 0).
+        target_rf     = Signal(32)
+        epoch         = Signal(32)
+        phase_capture = Signal(32)
+        realign       = Signal()
+        self.specials += MultiReg(config["1s_target"], target_rf, odomain=cd_rf)
+        self.realign_ps = realign_ps = PulseSynchronizer("sys", cd_rf)
+        self.comb += realign_ps.i.eq(self._realign.re)
+        sync_rf += [
+            If(epoch >= (target_rf - 1),
+                epoch.eq(0)
+            ).Else(
+                epoch.eq(epoch + 1)
+            ),
+            If(realign_ps.o,
+                realign.eq(1)
+            ),
+            If(pps_rf & ~pps_rf_d,
+                phase_capture.eq(epoch),
+                If(realign,
+                    epoch.eq(0),
+                    phase_capture.eq(0),
+                    realign.eq(0),
+                )
+            )
+        ]
+
+        # Transfer to sys: capture is stable for ~1s after each toggle.
+        toggle_sys   = Signal()
+        toggle_sys_d = Signal()
+        self.specials += MultiReg(toggle, toggle_sys)
+        self.sync += [
+            toggle_sys_d.eq(toggle_sys),
+            If(toggle_sys != toggle_sys_d,
+                self._timestamp.status.eq(capture),
+                # Wrap the phase to +/- half a period.
+                If(phase_capture > (config["1s_target"] >> 1),
+                    self.phase_error.eq(phase_capture - config["1s_target"])
+                ).Else(
+                    self.phase_error.eq(phase_capture)
+                )
+            )
+        ]
+        self.comb += [
+            self.ev.pps.trigger.eq(toggle_sys != toggle_sys_d),
+            self._phase.status.eq(self.phase_error),
+        ]
+
+        # Config (the firmware computes the interval errors).
+        self.comb += [
+            self._target_1s.status.eq(config["1s_target"]),
+            self._tol_1s.status.eq(config["1s_tol"]),
+            self._target_10s.status.eq(config["10s_target"]),
+            self._tol_10s.status.eq(config["10s_tol"]),
+            self._target_100s.status.eq(config["100s_target"]),
+            self._tol_100s.status.eq(config["100s_tol"]),
+        ]
+
+# VCTCXO Tamer Long Window -------------------------------------------------------------------------
+
+class _VCTCXOTamerLong(LiteXModule):
+    def __init__(self, pps, length, target, tol, error, cd_rf="rf"):
+        self.done     = Signal()
+
+        self._len     = CSRStatus(16, description="Long window length (seconds).")
+        self._target  = CSRStatus(32, description="Target value for the long window (modulo 2^32).")
+        self._tol     = CSRStatus(32, description="Tolerance for the long window.")
+        self._error   = CSRStatus(32, description="Error value for the last long window (signed).")
+        self._seq     = CSRStatus(32, description="Long window sequence counter (windows completed).")
+        self._restart = CSRStorage(description="Write to restart the long window on the next PPS.")
+
+        # # #
+
+        # RF clock cycles counted over len PPS periods, back to back (the end of a window is the
+        # start of the next one). The counter wraps: the error is taken modulo 2^32 against the
+        # target modulo 2^32, valid for errors within +/-2^31 whatever the window length.
+        pps_rf   = Signal()
+        pps_rf_d = Signal()
+        count    = Signal(32)
+        start    = Signal(32)
+        seconds  = Signal(16)
+        len_rf   = Signal(16)
+        valid    = Signal()
+        done     = Signal(32)
+        toggle   = Signal()
+        self.specials += MultiReg(pps,    pps_rf, odomain=cd_rf)
+        self.specials += MultiReg(length, len_rf, odomain=cd_rf)
+        self.restart_ps = restart_ps = PulseSynchronizer("sys", cd_rf)
+        self.comb += restart_ps.i.eq(self._restart.re)
+        restart = Signal()
+        sync_rf = getattr(self.sync, cd_rf)
+        sync_rf += [
+            count.eq(count + 1),
+            pps_rf_d.eq(pps_rf),
+            If(restart_ps.o,
+                restart.eq(1)
+            ),
+            If(pps_rf & ~pps_rf_d,
+                seconds.eq(seconds + 1),
+                If(restart | ~valid | (len_rf == 0),
+                    start.eq(count),
+                    seconds.eq(1),
+                    valid.eq(len_rf != 0),
+                    restart.eq(0),
+                ).Elif(seconds >= len_rf,
+                    done.eq(count - start),
+                    start.eq(count),
+                    seconds.eq(1),
+                    toggle.eq(~toggle),
+                )
+            )
+        ]
+
+        # Transfer to sys: done is stable for len seconds after each toggle.
+        toggle_sys   = Signal()
+        toggle_sys_d = Signal()
+        self.specials += MultiReg(toggle, toggle_sys)
+        self.sync += [
+            toggle_sys_d.eq(toggle_sys),
+            If(toggle_sys != toggle_sys_d,
+                error.eq(done - target),
+                self._seq.status.eq(self._seq.status + 1),
+            )
+        ]
+        self.comb += [
+            self.done.eq(toggle_sys != toggle_sys_d),
+            self._len.status.eq(length),
+            self._target.status.eq(target),
+            self._tol.status.eq(tol),
+            self._error.status.eq(error),
+        ]
+
+# VCTCXO Tamer IRQ ---------------------------------------------------------------------------------
+
+class _VCTCXOTamerIRQ(LiteXModule):
+    def __init__(self, irq, enable, pps_active, long_done):
+        self.ev = EventManager()
+        self.ev.pps        = EventSourceLevel(description="VCTCXO Tamer PPS measurement ready.")
+        self.ev.enable     = EventSourceProcess(edge="any", description="VCTCXO Tamer enable change.")
+        self.ev.pps_active = EventSourceProcess(edge="any", description="PPS active change (holdover).")
+        self.ev.long       = EventSourcePulse(description="VCTCXO Tamer long window completed.")
+        self.ev.finalize()
+
+        # # #
+
+        self.comb += [
+            self.ev.pps.trigger.eq(irq),
+            self.ev.enable.trigger.eq(enable),
+            self.ev.pps_active.trigger.eq(pps_active),
+            self.ev.long.trigger.eq(long_done),
+        ]
+
+# PPS Status ---------------------------------------------------------------------------------------
+
+class _PPSStatus(LiteXModule):
+    def __init__(self, pps_active):
+        self._active = CSRStatus(description="PPS active status (from PPS Detector).")
+
+        # # #
+
+        self.comb += self._active.status.eq(pps_active)
+
+# PPS Select ---------------------------------------------------------------------------------------
+
+class _PPSSelect(LiteXModule):
+    def __init__(self, pps, actives, cd_rf="rf"):
+        n = len(actives)
+        self.pps        = Signal()
+        self.pps_active = Signal()
+        self.source     = Signal(2)
+
+        self._source       = CSRStorage(2,  description="Selected PPS source.")
+        self._active       = CSRStatus(n,   description="PPS active status of each source (from PPS Detectors).")
+        self._rd_source    = CSRStorage(2,  description="PPS source read through rd_timestamp/rd_count.")
+        self._rd_timestamp = CSRStatus(32,  description="RF clock count captured on the last PPS rising edge of rd_source.")
+        self._rd_count     = CSRStatus(8,   description="PPS rising edges count of rd_source (coherent read check).")
+
+        # # #
+
+        # Free-running RF clock counter captured on the PPS rising edges of each source, so that
+        # the firmware can compare the sources (jitter, offset) while one of them is disciplining.
+        count   = Signal(32)
+        sync_rf = getattr(self.sync, cd_rf)
+        sync_rf += count.eq(count + 1)
+        timestamps = []
+        counts     = []
+        for i in range(n):
+            pps_rf       = Signal()
+            pps_rf_d     = Signal()
+            capture      = Signal(32)
+            toggle       = Signal()
+            toggle_sys   = Signal()
+            toggle_sys_d = Signal()
+            timestamp    = Signal(32)
+            edges        = Signal(8)
+            self.specials += MultiReg(pps[i], pps_rf, odomain=cd_rf)
+            sync_rf += [
+                pps_rf_d.eq(pps_rf),
+                If(pps_rf & ~pps_rf_d,
+                    capture.eq(count),
+                    toggle.eq(~toggle),
+                )
+            ]
+            # Transfer to sys: capture is stable for ~1s after each toggle.
+            self.specials += MultiReg(toggle, toggle_sys)
+            self.sync += [
+                toggle_sys_d.eq(toggle_sys),
+                If(toggle_sys != toggle_sys_d,
+                    timestamp.eq(capture),
+                    edges.eq(edges + 1),
+                )
+            ]
+            timestamps.append(timestamp)
+            counts.append(edges)
+        self.comb += [
+            self._active.status.eq(Cat(*actives)),
+            self._rd_timestamp.status.eq(Array(timestamps)[self._rd_source.storage]),
+            self._rd_count.status.eq(Array(counts)[self._rd_source.storage]),
+        ]
+
+        # Source mux: a new selection is only applied while both the current and the new source PPS
+        # are low, so that a switch does not produce a spurious PPS edge. The PPS active status
+        # follows the requested source (a failover does not go through holdover).
+        pps_sys = Signal(n)
+        self.specials += MultiReg(pps, pps_sys)
+        self.sync += If(~Array(pps_sys)[self.source] & ~Array(pps_sys)[self._source.storage],
+            self.source.eq(self._source.storage)
+        )
+        self.comb += [
+            self.pps.eq(Array(pps)[self.source]),
+            self.pps_active.eq(Array(actives)[self._source.storage]),
+        ]
+
+# 10 MHz Reference Tick ----------------------------------------------------------------------------
+
+class _RefTick(LiteXModule):
+    def __init__(self, pps, pps_active, enable, div, timeout, cd_ref="ref"):
+        self.pps        = Signal()
+        self.pps_active = Signal()
+
+        self._enable = CSRStatus(description="10 MHz reference mode (reference ticks measured instead of PPS).")
+        self._active = CSRStatus(description="10 MHz reference active status.")
+
+        # # #
+
+        # Reference ticks: the 10 MHz reference divided (in its own clock domain, so exactly) to a
+        # square wave at the tick rate, measured as PPS pulses by the Tamer/timestamps.
+        tick  = Signal()
+        count = Signal(max=div)
+        sync_ref = getattr(self.sync, cd_ref)
+        sync_ref += [
+            If(count == (div - 1),
+                count.eq(0)
+            ).Else(
+                count.eq(count + 1)
+            ),
+            tick.eq(count < (div//2)),
+        ]
+
+        # Reference active: tick rising edges seen within the timeout (sys clock cycles).
+        tick_sys   = Signal()
+        tick_sys_d = Signal()
+        watchdog   = Signal(max=timeout + 1)
+        ref_active = Signal()
+        self.specials += MultiReg(tick, tick_sys)
+        self.sync += [
+            tick_sys_d.eq(tick_sys),
+            If(tick_sys & ~tick_sys_d,
+                watchdog.eq(0)
+            ).Elif(watchdog != timeout,
+                watchdog.eq(watchdog + 1)
+            )
+        ]
+        self.comb += ref_active.eq(watchdog != timeout)
+
+        # Mode mux: a mode change is only applied while both the PPS and the ticks are low, so that
+        # it does not produce a spurious edge. The targets/tolerances are per measurement interval
+        # (1/tick rate): the host changes the mode with the PPSDO disabled.
+        pps_sys = Signal()
+        mode    = Signal()
+        self.specials += MultiReg(pps, pps_sys)
+        self.sync += If(~pps_sys & ~tick_sys, mode.eq(enable))
+        self.comb += [
+            self.pps.eq(Mux(mode, tick, pps)),
+            self.pps_active.eq(Mux(mode, ref_active, pps_active)),
+            self._enable.status.eq(mode),
+            self._active.status.eq(ref_active),
+        ]
+
+# Calibration --------------------------------------------------------------------------------------
+
+class _Calibration(LiteXModule):
+    def __init__(self, warm_start, warm_slope, warm_dac, slope):
+        self._warm_start = CSRStatus(description="Warm start: skip coarse tune using warm slope/DAC.")
+        self._warm_slope = CSRStatus(32, description="Warm start calibration slope (Q16.16, DAC counts/error count).")
+        self._warm_dac   = CSRStatus(16, description="Warm start trim DAC value.")
+        self._slope      = CSRStorage(32, description="Current calibration slope (Q16.16, DAC counts/error count).")
+
+        # # #
+
+        self.comb += [
+            self._warm_start.status.eq(warm_start),
+            self._warm_slope.status.eq(warm_slope),
+            self._warm_dac.status.eq(warm_dac),
+            slope.eq(self._slope.storage),
+        ]
+
+# Config Update ------------------------------------------------------------------------------------
+
+class _ConfigUpdate(LiteXModule):
+    def __init__(self, pps, enable, gen, config):
+        self.config = {name: Signal(len(sig), name=f"config_{name}") for name, sig in config.items()}
+
+        self._gen       = CSRStatus(8,  description="Applied configuration generation (config_gen of the applied targets/tolerances).")
+        self._target_1s = CSRStatus(32, description="Applied target value for 1-second interval.")
+
+        # # #
+
+        # Shadow targets/tolerances: followed while disabled; while enabled, the host writes the new
+        # values then changes config_gen and the whole set is applied on the next PPS edge, so that
+        # no measurement window mixes old and new values (the firmware rescales its calibration on
+        # the applied generation change).
+        pps_sys   = Signal()
+        pps_sys_d = Signal()
+        gen_sys   = Signal(8)
+        self.specials += MultiReg(pps, pps_sys)
+        self.specials += MultiReg(gen, gen_sys)
+        self.sync += [
+            pps_sys_d.eq(pps_sys),
+            If(~enable | (pps_sys & ~pps_sys_d & (gen_sys != self._gen.status)),
+                self._gen.status.eq(gen_sys),
+                [self.config[name].eq(sig) for name, sig in config.items()],
+            )
+        ]
+        self.comb += self._target_1s.status.eq(self.config["1s_target"])
+
+# Cycle Counter ------------------------------------------------------------------------------------
+
+class _CycleCounter(LiteXModule):
+    def __init__(self):
+        self._value   = CSRStatus(32,  description="Free-running sys clock cycle counter.")
+        self._compare = CSRStorage(32, description="Compare value: compare event when the counter reaches it.")
+        self.ev = EventManager()
+        self.ev.compare = EventSourcePulse(description="Cycle counter reached the compare value.")
+        self.ev.finalize()
+
+        # # #
+
+        value = Signal(32)
+        self.sync += value.eq(value + 1)
+        self.comb += [
+            self._value.status.eq(value),
+            self.ev.compare.trigger.eq(value == self._compare.storage),
+        ]
+
+# Profiler -----------------------------------------------------------------------------------------
+
+class _Profiler(LiteXModule):
+    def __init__(self, slots=16):
+        self._slot     = CSRStorage(8,  description="Profiling slot of the next sample.")
+        self._sample   = CSRStorage(32, description="Write a cycle count to the slot (updates last/min/max/count).")
+        self._rd_slot  = CSRStorage(8,  description="Profiling slot to read.")
+        self._rd_last  = CSRStatus(32, description="Last cycle count of the read slot.")
+        self._rd_min   = CSRStatus(32, description="Minimum cycle count of the read slot.")
+        self._rd_max   = CSRStatus(32, description="Maximum cycle count of the read slot.")
+        self._rd_count = CSRStatus(32, description="Number of samples of the read slot.")
+
+        # # #
+
+        # Per-slot statistics: [31:0] last, [63:32] min, [95:64] max, [127:96] count. Kept in a
+        # memory and updated in hardware so that the firmware spends no SRAM/cycles on them.
+        mem = Memory(128, slots, init=[0xffffffff << 32]*slots)
+        wr  = mem.get_port(write_capable=True)
+        rd  = mem.get_port()
+        self.specials += mem, wr, rd
+
+        sample  = Signal(32)
+        s_last  = Signal(32)
+        s_min   = Signal(32)
+        s_max   = Signal(32)
+        s_count = Signal(32)
+        update  = Signal()
+        self.comb += [
+            wr.adr.eq(self._slot.storage),
+            Cat(s_last, s_min, s_max, s_count).eq(wr.dat_r),
+            wr.dat_w.eq(Cat(
+                sample,
+                Mux(sample < s_min, sample, s_min),
+                Mux(sample > s_max, sample, s_max),
+                s_count + 1,
+            )),
+            wr.we.eq(update),
+        ]
+        # Read the slot on the sample write, update it on the next cycle (read-modify-write).
+        self.sync += [
+            update.eq(self._sample.re),
+            If(self._sample.re,
+                sample.eq(self._sample.storage)
+            )
+        ]
+
+        # Readout.
+        self.comb += [
+            rd.adr.eq(self._rd_slot.storage),
+            self._rd_last.status.eq(rd.dat_r[0:32]),
+            self._rd_min.status.eq(rd.dat_r[32:64]),
+            self._rd_max.status.eq(rd.dat_r[64:96]),
+            self._rd_count.status.eq(rd.dat_r[96:128]),
+        ]
+
+# Temperature Compensation -------------------------------------------------------------------------
+
+class _TempComp(LiteXModule):
+    def __init__(self, temp):
+        self._temp  = CSRStatus(16, description="Temperature from the host (signed, 1/16 C).")
+        self._valid = CSRStatus(description="Temperature valid (temp != 0x8000).")
+
+        # # #
+
+        self.comb += [
+            self._temp.status.eq(temp),
+            self._valid.status.eq(temp != 0x8000),
+        ]
+
+# Outlier Filter -----------------------------------------------------------------------------------
+
+class _OutlierFilter(LiteXModule):
+    def __init__(self, rejected):
+        self._rejected = CSRStorage(32, description="Number of PPS error samples rejected as outliers.")
+
+        # # #
+
+        self.comb += rejected.eq(self._rejected.storage)
+
+# Lock Quality -------------------------------------------------------------------------------------
+
+class _LockQuality(LiteXModule):
+    def __init__(self, tol, status):
+        self._tol = CSRStatus(32, description="Lock threshold on the 1s RMS error (counts, Q8, 0: 1s tolerance).")
+        self._mean_1s   = CSRStorage(32, description="1s error mean (signed, counts, Q8).")
+        self._rms_1s    = CSRStorage(32, description="1s error RMS (counts, Q8).")
+        self._max_1s    = CSRStorage(32, description="1s error decaying max |error| (counts, Q8).")
+        self._mean_10s  = CSRStorage(32, description="10s error mean (signed, counts, Q8).")
+        self._rms_10s   = CSRStorage(32, description="10s error RMS (counts, Q8).")
+        self._max_10s   = CSRStorage(32, description="10s error decaying max |error| (counts, Q8).")
+        self._mean_100s = CSRStorage(32, description="100s error mean (signed, counts, Q8).")
+        self._rms_100s  = CSRStorage(32, description="100s error RMS (counts, Q8).")
+        self._max_100s  = CSRStorage(32, description="100s error decaying max |error| (counts, Q8).")
+        self._locked    = CSRStorage(1,  description="Locked (hysteresis on the 1s RMS error).")
+        self._lock_time = CSRStorage(32, description="Time since lock (seconds).")
+
+        # # #
+
+        self.comb += [
+            self._tol.status.eq(tol),
+            status["1s_mean"]  .eq(self._mean_1s.storage),
+            status["1s_rms"]   .eq(self._rms_1s.storage),
+            status["1s_max"]   .eq(self._max_1s.storage),
+            status["10s_mean"] .eq(self._mean_10s.storage),
+            status["10s_rms"]  .eq(self._rms_10s.storage),
+            status["10s_max"]  .eq(self._max_10s.storage),
+            status["100s_mean"].eq(self._mean_100s.storage),
+            status["100s_rms"] .eq(self._rms_100s.storage),
+            status["100s_max"] .eq(self._max_100s.storage),
+            status["locked"]   .eq(self._locked.storage),
+            status["lock_time"].eq(self._lock_time.storage),
+        ]
+
+# History ------------------------------------------------------------------------------------------
+
+class _History(LiteXModule):
+    def __init__(self, rd_addr, rd_data, seq, depth=64):
+        assert depth >= 2 and (depth & (depth - 1)) == 0
+        aw = log2_int(depth)
+
+        self._data0 = CSRStorage(32, description="History sample: 1s error.")
+        self._data1 = CSRStorage(24, description="History sample: DAC value [15:0], state [19:16], flags [23:20].")
+        self._push  = CSRStorage(description="Write to push the sample to the history.")
+        self._seq   = CSRStatus(32, description="History sequence counter (number of samples pushed).")
+
+        # # #
+
+        # Ring buffer: sample N is stored at N % depth with the 8 LSBs of N in [63:56].
+        count = Signal(32)
+        mem   = Memory(64, depth)
+        wport = mem.get_port(write_capable=True)
+        rport = mem.get_port()
+        self.specials += mem, wport, rport
+        self.comb += [
+            wport.adr.eq(count[:aw]),
+            wport.dat_w.eq(Cat(self._data0.storage, self._data1.storage, count[:8])),
+            wport.we.eq(self._push.re),
+            rport.adr.eq(rd_addr[:aw]),
+            rd_data.eq(rport.dat_r),
+            seq.eq(count),
+            self._seq.status.eq(count),
+        ]
+        self.sync += If(self._push.re, count.eq(count + 1))
+
+# DAC Dither ---------------------------------------------------------------------------------------
+
+class _DACDither(LiteXModule):
+    def __init__(self, dac_in, dac_max, frac_bits, div):
+        self._frac = CSRStorage(frac_bits, description="Fractional part of the trim DAC value (1/2^N DAC counts).")
+        self.dac   = Signal(len(dac_in))
+
+        # # #
+
+        # Update strobe (DAC output rate).
+        count  = Signal(max=div)
+        strobe = Signal()
+        self.sync += [
+            strobe.eq(count == 0),
+            If(count == 0,
+                count.eq(div - 1),
+            ).Else(
+                count.eq(count - 1),
+            )
+        ]
+
+        # First-order sigma-delta: the accumulator carry adds one DAC count, so that the average
+        # output is dac_in + frac/2^N (saturated at dac_max).
+        acc   = Signal(frac_bits)
+        carry = Signal()
+        self.sync += If(strobe, Cat(acc, carry).eq(acc + self._frac.storage))
+        self.comb += self.dac.eq(Mux(carry & (dac_in < dac_max), dac_in + 1, dac_in))
+
 # PPSDO --------------------------------------------------------------------------------------------
 
 class PPSDO(SoCCore):
-    def __init__(self, sys_clk_freq=6e6, dac_bits=16, firmware_path=None, **kwargs):
-        platform = Platform()
+    def __init__(self, sys_clk_freq=6e6, dac_bits=16, fixed_point=False,
+        coarse_tune="minmax", fine_tune="proportional", pi_kp_shift=2, pi_ki_shift=6,
+        adaptive_max_level=5, history_depth=64, continuous=False, outlier_window=0, outlier_floor=64,
+        temp_comp=False, temp_comp_min=-40, temp_comp_step=8, with_profiler=False, telemetry=False,
+        with_cycle_counter=False, dac_slew="none", dac_slew_step=256, dac_slew_shift=2,
+        dac_slew_tick_ms=10, dac_settle_ms=100, dac_frac_bits=0, dac_dither_freq=1e3,
+        lock_quality=False, lock_quality_shift=6, pps_inputs=1, ref_10mhz=False, ref_rate=10,
+        config_update=False, with_calibration=False, with_history=False, with_snapshot=False,
+        with_long_window=False, with_holdover=False, rom_size=0x2000, sram_size=0x100, firmware_path=None,
+        **kwargs):
+        platform = Platform(pps_inputs)
 
         # SoCCore ----------------------------------------------------------------------------------
 
         # Minimal config to reduce resource usage on small FPGAs:
         # - SERV CPU      : Compact RISC-V to minimize logic.
         # - No timer/ctrl : Not needed; saves resources.
-        # - SRAM          : Minimal stack/scratchpad.
-        # - ROM           : Automatically reduced to used space by LiteX.
+        # - SRAM          : Minimal stack/scratchpad (sram_size, sized to the firmware needs).
+        # - ROM           : Firmware (rom_size), automatically reduced to used space by LiteX.
 
         kwargs["cpu_type"]             = "fazyrv" # Looks like serv has issues with floating point math, changed to fazyrv
         kwargs["with_timer"]           = False
         kwargs["with_ctrl"]            = False
         kwargs["uart_name"]            = "uart"
-        kwargs["integrated_sram_size"] = 0x100
-        kwargs["integrated_rom_size"]  = 0x2000
+        kwargs["integrated_sram_size"] = sram_size
+        kwargs["integrated_rom_size"]  = rom_size
         kwargs["integrated_rom_init"]  = firmware_path
 
+        # Telemetry: UART TX FIFO sized for a full frame, used as the firmware's non-blocking buffer.
+        if telemetry:
+            kwargs["uart_fifo_depth"] = 32
+
         SoCCore.__init__(self, platform, sys_clk_freq, **kwargs)
 
         # DAC config
@@ -136,9 +786,111 @@ class PPSDO(SoCCore):
         self.add_constant("CONFIG_DAC_MIN", 0)
         self.add_constant("CONFIG_DAC_MAX", dac_max)
 
+        # Firmware delay_ms() busy loop iterations per ms (~320 cycles/iteration).
+        self.add_constant("CONFIG_DELAY_MS_LOOPS", max(1, int(sys_clk_freq) // 320000))
+
+        # Firmware config
+        # Fixed-point (Q16.16) calibration/fine tune math: avoids soft-float/libm in firmware.
+        if fixed_point:
+            self.add_constant("CONFIG_FIXED_POINT")
+
+        # COARSE_TUNE strategy:
+        # - minmax : Measure at min/max DAC values and use the line intercept.
+        # - search : Secant/bisection search starting from the default DAC value (needs continuous:
+        #            errors within the tolerance are never reported by the Tamer).
+        assert coarse_tune in ["minmax", "search"]
+        assert (coarse_tune != "search") or continuous
+        if coarse_tune == "search":
+            self.add_constant("CONFIG_COARSE_TUNE_SEARCH")
+
+        # FINE_TUNE engine:
+        # - proportional : One-shot correction of the 1s/10s/100s error when out of tolerance.
+        # - pi           : Digital PI (type-2 PLL) loop run on every 1s sample, gains 2^-kp/2^-ki
+        #                  (needs continuous: the Tamer only reports out of tolerance errors).
+        # - phase        : PI loop on the measured PPS phase error (phase lock, needs continuous).
+        # - adaptive     : 1s errors summed over 4^N s windows, N (up to adaptive_max_level) selected
+        #                  from the measured error variance (needs continuous).
+        assert fine_tune in ["proportional", "pi", "phase", "adaptive"]
+        assert (fine_tune not in ["pi", "phase", "adaptive"]) or continuous
+        if fine_tune in ["pi", "phase"]:
+            assert pi_ki_shift >= pi_kp_shift
+            self.add_constant({"pi": "CONFIG_FINE_TUNE_PI", "phase": "CONFIG_FINE_TUNE_PHASE"}[fine_tune])
+            self.add_constant("CONFIG_PI_KP_SHIFT", pi_kp_shift)
+            self.add_constant("CONFIG_PI_KI_SHIFT", pi_ki_shift)
+        if fine_tune == "adaptive":
+            assert 0 <= adaptive_max_level <= 7
+            self.add_constant("CONFIG_FINE_TUNE_ADAPTIVE")
+            self.add_constant("CONFIG_ADAPTIVE_MAX_LEVEL", adaptive_max_level)
+
+        # FINE_TUNE outlier rejection: 1s errors deviating from the median of the last N samples by
+        # more than max(4 * MAD, floor) are dropped before the control law (0: disabled). Without
+        # continuous, the Tamer only reports out of tolerance errors: the median/MAD statistics are
+        # then those of the out of tolerance samples only (biased).
+        if outlier_window:
+            assert outlier_window in [3, 5, 7, 9]
+            self.add_constant("CONFIG_OUTLIER_WINDOW", outlier_window)
+            self.add_constant("CONFIG_OUTLIER_FLOOR",  outlier_floor)
+
+        # Temperature compensation: trim DAC table learned in FINE_TUNE at 16 temperature nodes
+        # (every temp_comp_step C, power of 2, from temp_comp_min C) and used as feed-forward.
+        if temp_comp:
+            assert temp_comp_step in [1, 2, 4, 8, 16]
+            self.add_constant("CONFIG_TEMP_COMP")
+            self.add_constant("CONFIG_TEMP_COMP_MIN",   temp_comp_min*16)
+            self.add_constant("CONFIG_TEMP_COMP_SHIFT", log2_int(temp_comp_step*16))
+
+        # Holdover: trim DAC steered from a drift model learned in FINE_TUNE while PPS is lost
+        # (otherwise held at its last value).
+        if with_holdover:
+            self.add_constant("CONFIG_HOLDOVER")
+
+        # Telemetry: binary frame (state, errors, DAC value, flags, sequence number, CRC) sent on the
+        # UART for each processed PPS measurement.
+        if telemetry:
+            self.add_constant("CONFIG_TELEMETRY")
+
+        # DAC slew: trim DAC ramped to new values from the firmware main loop (fixed step or
+        # exponential), then settle interval before the measurements restart.
+        assert dac_slew in ["none", "step", "exp"]
+        if dac_slew != "none":
+            self.add_constant("CONFIG_DAC_SLEW")
+            if dac_slew == "step":
+                self.add_constant("CONFIG_DAC_SLEW_STEP", dac_slew_step)
+            else:
+                self.add_constant("CONFIG_DAC_SLEW_SHIFT", dac_slew_shift)
+            self.add_constant("CONFIG_DAC_SLEW_TICK_MS",   dac_slew_tick_ms)
+            self.add_constant("CONFIG_DAC_SLEW_SETTLE_MS", dac_settle_ms)
+
+        # DAC dither: fractional trim DAC value (1/2^N DAC counts) sigma-delta modulated on the DAC
+        # output by the gateware.
+        assert 0 <= dac_frac_bits <= 8
+        if dac_frac_bits:
+            self.add_constant("CONFIG_DAC_FRAC_BITS", dac_frac_bits)
+
+        # Lock quality: FINE_TUNE error statistics over a 2^N samples exponential window and lock
+        # decision exported on the status outputs (needs a measurement on every PPS).
+        if lock_quality:
+            assert continuous
+            self.add_constant("CONFIG_LOCK_QUALITY_SHIFT", lock_quality_shift)
+
+        # PPS inputs: per-source jitter scores voted by the firmware, with hitless switching to the
+        # best source and failover on PPS loss (needs the PPS timestamps).
+        assert 1 <= pps_inputs <= 4
+        if pps_inputs > 1:
+            assert continuous
+            self.add_constant("CONFIG_PPS_INPUTS", pps_inputs)
+
+        # 10 MHz reference: divided to ref_rate ticks per second, measured instead of PPS when
+        # selected by the host (1/ref_rate s measurement intervals, the loops lock that many times
+        # faster).
+        if ref_10mhz:
+            assert ref_rate in [1, 2, 5, 10, 20, 50, 100]
+            self.add_constant("CONFIG_REF_RATE",  ref_rate)
+            self.add_constant("CONFIG_REF_SHIFT", ref_rate.bit_length() - 1)
+
         # CRG --------------------------------------------------------------------------------------
 
-        self.crg = _CRG(platform)
+        self.crg = _CRG(platform, with_ref=ref_10mhz)
 
         # Pads -------------------------------------------------------------------------------------
 
@@ -152,21 +904,108 @@ class PPSDO(SoCCore):
         config_10s_tol       = platform.request("config_10s_tol")
         config_100s_target   = platform.request("config_100s_target")
         config_100s_tol      = platform.request("config_100s_tol")
+        config_long_len      = platform.request("config_long_len")
+        config_long_target   = platform.request("config_long_target")
+        config_long_tol      = platform.request("config_long_tol")
+        config_temp          = platform.request("config_temp")
+        config_warm_start    = platform.request("config_warm_start")
+        config_warm_slope    = platform.request("config_warm_slope")
+        config_warm_dac      = platform.request("config_warm_dac")
+        config_lock_tol      = platform.request("config_lock_tol")
+        config_ref_enable    = platform.request("config_ref_enable")
+        config_gen           = platform.request("config_gen")
 
         # Status pads.
         status_1s_error      = platform.request("status_1s_error")
         status_10s_error     = platform.request("status_10s_error")
         status_100s_error    = platform.request("status_100s_error")
+        status_long_error    = platform.request("status_long_error")
         status_dac_tuned_val = platform.request("status_dac_tuned_val")
         status_accuracy      = platform.request("status_accuracy")
         status_state         = platform.request("status_state")
         status_pps_active    = platform.request("status_pps_active")
+        status_slope         = platform.request("status_slope")
+        status_phase_error   = platform.request("status_phase_error")
+        status_rejected      = platform.request("status_rejected")
+        status_pps_source    = platform.request("status_pps_source")
+        status_pps_sources_active = platform.request("status_pps_sources_active")
+        status_lock_quality  = {name: platform.request(f"status_{name}") for name in [
+            "1s_mean",   "1s_rms",   "1s_max",
+            "10s_mean",  "10s_rms",  "10s_max",
+            "100s_mean", "100s_rms", "100s_max",
+            "locked",    "lock_time"]}
+
+        # History pads.
+        history_rd_addr      = platform.request("history_rd_addr")
+        history_rd_data      = platform.request("history_rd_data")
+        history_seq          = platform.request("history_seq")
 
         # PPS Detector -----------------------------------------------------------------------------
 
-        self.pps_detector = PPSDetector(pps=pps)
+        self.pps_detector = PPSDetector(pps=pps[0] if pps_inputs > 1 else pps)
         self.pps_detector.add_sources()
-        self.comb += status_pps_active.eq(self.pps_detector.pps_active)
+        pps_actives = [self.pps_detector.pps_active]
+        for i in range(1, pps_inputs):
+            pps_detector = PPSDetector(pps=pps[i])
+            setattr(self, f"pps_detector{i}", pps_detector)
+            pps_actives.append(pps_detector.pps_active)
+
+        # PPS Select -------------------------------------------------------------------------------
+
+        # Multiple PPS inputs: the selected source drives the Tamer/timestamps, the others are only
+        # timestamped for the firmware voting.
+        if pps_inputs > 1:
+            self.pps_select = _PPSSelect(pps=pps, actives=pps_actives)
+            pps        = self.pps_select.pps
+            pps_active = self.pps_select.pps_active
+            self.comb += [
+                status_pps_source.eq(self.pps_select.source),
+                status_pps_sources_active.eq(Cat(*pps_actives)),
+            ]
+        else:
+            pps_active = self.pps_detector.pps_active
+            self.comb += [
+                status_pps_source.eq(0),
+                status_pps_sources_active.eq(pps_active),
+            ]
+
+        # 10 MHz Reference Tick --------------------------------------------------------------------
+
+        # Lab references (rubidium, house 10 MHz): reference ticks replace the PPS for the Tamer,
+        # timestamps and activity when config_ref_enable is set.
+        if ref_10mhz:
+            self.ref_tick = _RefTick(
+                pps        = pps,
+                pps_active = pps_active,
+                enable     = config_ref_enable,
+                div        = 10_000_000//ref_rate,
+                timeout    = 2*int(sys_clk_freq)//ref_rate,
+            )
+            pps        = self.ref_tick.pps
+            pps_active = self.ref_tick.pps_active
+        self.comb += status_pps_active.eq(pps_active)
+
+        # Let the firmware stop acting on the counts (holdover) when PPS is lost.
+        self.pps_status = _PPSStatus(pps_active=pps_active)
+
+        # Config Update ----------------------------------------------------------------------------
+
+        # Targets/tolerances of the measurement windows, optionally updated at runtime (e.g. RF
+        # clock change) through the config_gen handshake instead of a disable/enable and relock.
+        config = {
+            "1s_target"   : config_1s_target,
+            "1s_tol"      : config_1s_tol,
+            "10s_target"  : config_10s_target,
+            "10s_tol"     : config_10s_tol,
+            "100s_target" : config_100s_target,
+            "100s_tol"    : config_100s_tol,
+            "long_len"    : config_long_len,
+            "long_target" : config_long_target,
+            "long_tol"    : config_long_tol,
+        }
+        if config_update:
+            self.config_update = _ConfigUpdate(pps=pps, enable=enable, gen=config_gen, config=config)
+            config = self.config_update.config
 
         # VCTCXO Tamer -----------------------------------------------------------------------------
 
@@ -175,22 +1014,161 @@ class PPSDO(SoCCore):
         self.bus.add_slave("vctcxo_tamer", self.vctcxo_tamer.bus, region=SoCRegion(size=0x1000))
         self.comb += [
             # Config.
-            self.vctcxo_tamer.config_1s_target  .eq(config_1s_target),
-            self.vctcxo_tamer.config_1s_tol     .eq(config_1s_tol),
-            self.vctcxo_tamer.config_10s_target .eq(config_10s_target),
-            self.vctcxo_tamer.config_10s_tol    .eq(config_10s_tol),
-            self.vctcxo_tamer.config_100s_target.eq(config_100s_target),
-            self.vctcxo_tamer.config_100s_tol   .eq(config_100s_tol),
+            self.vctcxo_tamer.config_1s_target  .eq(config["1s_target"]),
+            self.vctcxo_tamer.config_1s_tol     .eq(config["1s_tol"]),
+            self.vctcxo_tamer.config_10s_target .eq(config["10s_target"]),
+            self.vctcxo_tamer.config_10s_tol    .eq(config["10s_tol"]),
+            self.vctcxo_tamer.config_100s_target.eq(config["100s_target"]),
+            self.vctcxo_tamer.config_100s_tol   .eq(config["100s_tol"]),
 
             # Status.
             status_1s_error      .eq(self.vctcxo_tamer.status_1s_error),
             status_10s_error     .eq(self.vctcxo_tamer.status_10s_error),
             status_100s_error    .eq(self.vctcxo_tamer.status_100s_error),
-            status_dac_tuned_val .eq(self.vctcxo_tamer.status_dac_tuned_val),
             status_accuracy      .eq(self.vctcxo_tamer.status_accuracy),
             status_state         .eq(self.vctcxo_tamer.status_state),
         ]
 
+        # DAC Dither -------------------------------------------------------------------------------
+
+        # Optional sub-LSB trim DAC resolution: the DAC output toggles between two adjacent values
+        # at dac_dither_freq, averaged by the VCTCXO tuning input filter.
+        if dac_frac_bits:
+            self.dac_dither = _DACDither(
+                dac_in    = self.vctcxo_tamer.status_dac_tuned_val,
+                dac_max   = dac_max,
+                frac_bits = dac_frac_bits,
+                div       = max(1, int(sys_clk_freq/dac_dither_freq)),
+            )
+            self.comb += status_dac_tuned_val.eq(self.dac_dither.dac)
+        else:
+            self.comb += status_dac_tuned_val.eq(self.vctcxo_tamer.status_dac_tuned_val)
+
+        # VCTCXO Tamer Snapshot --------------------------------------------------------------------
+
+        # Optional errors latched on the Tamer IRQ (3 x 32-bit): coherent single word reads with the
+        # counters kept running, instead of stopping them for the byte reads.
+        if with_snapshot:
+            self.vctcxo_tamer_snapshot = _VCTCXOTamerSnapshot(
+                irq      = self.vctcxo_tamer.irq,
+                err_1s   = self.vctcxo_tamer.status_1s_error,
+                err_10s  = self.vctcxo_tamer.status_10s_error,
+                err_100s = self.vctcxo_tamer.status_100s_error,
+            )
+
+        # VCTCXO Tamer Long Window -----------------------------------------------------------------
+
+        # Optional fourth, configurable-length (config_long_len seconds, 0: disabled) averaging window
+        # for resolutions beyond the 100s window (e.g. 1000s: ~3e-11 at 30.72MHz).
+        long_done = Signal()
+        if with_long_window:
+            self.vctcxo_tamer_long = _VCTCXOTamerLong(
+                pps    = pps,
+                length = config["long_len"],
+                target = config["long_target"],
+                tol    = config["long_tol"],
+                error  = status_long_error,
+            )
+            self.comb += long_done.eq(self.vctcxo_tamer_long.done)
+        else:
+            self.comb += status_long_error.eq(0)
+
+        # Calibration ------------------------------------------------------------------------------
+
+        # Optional calibration slope export so that it can be saved by the host and given back with
+        # the last DAC value on a warm start, skipping the coarse tune (and its full-scale DAC swings).
+        if with_calibration:
+            self.calibration = _Calibration(
+                warm_start = config_warm_start,
+                warm_slope = config_warm_slope,
+                warm_dac   = config_warm_dac,
+                slope      = status_slope,
+            )
+        else:
+            self.comb += status_slope.eq(0)
+
+        # Cycle Counter ----------------------------------------------------------------------------
+
+        # Optional free-running cycle counter (much smaller than the LiteX timer) for exact firmware
+        # delays/timestamps; the compare event lets the CPU sleep (wfi) during delays.
+        if with_cycle_counter or with_profiler:
+            self.cycle_counter = _CycleCounter()
+            if self.irq.enabled:
+                self.irq.add("cycle_counter", use_loc_if_exists=True)
+
+        # Profiler ---------------------------------------------------------------------------------
+
+        # Optional per-slot (FSM states, ISR, PPS to DAC latency) min/max/last cycle counts (from the
+        # cycle counter), reported by the firmware on the UART.
+        if with_profiler:
+            self.profiler = _Profiler()
+
+        # Temperature Compensation -----------------------------------------------------------------
+
+        # Host provided temperature (0x8000: not available) for the firmware feed-forward.
+        if temp_comp:
+            self.temp_comp = _TempComp(temp=config_temp)
+
+        # Outlier Filter ---------------------------------------------------------------------------
+
+        # Exposes the number of 1s error samples rejected by the firmware outlier filter.
+        if outlier_window:
+            self.outlier_filter = _OutlierFilter(rejected=status_rejected)
+        else:
+            self.comb += status_rejected.eq(0)
+
+        # Lock Quality -----------------------------------------------------------------------------
+
+        # Firmware computed FINE_TUNE error mean/RMS/max of the 1s/10s/100s intervals, lock decision
+        # and time since lock, so that the host can gate on the lock quality without the samples.
+        if lock_quality:
+            self.lock_quality = _LockQuality(tol=config_lock_tol, status=status_lock_quality)
+        else:
+            self.comb += [pad.eq(0) for pad in status_lock_quality.values()]
+
+        # History ----------------------------------------------------------------------------------
+
+        # Optional per-PPS (error, DAC, state, flags) samples pushed by the firmware, drained by the
+        # host (history_depth x 64-bit memory).
+        if with_history:
+            self.history = _History(
+                rd_addr = history_rd_addr,
+                rd_data = history_rd_data,
+                seq     = history_seq,
+                depth   = history_depth,
+            )
+        else:
+            self.comb += [
+                history_rd_data.eq(0),
+                history_seq.eq(0),
+            ]
+
+        # PPS Timestamp ----------------------------------------------------------------------------
+
+        # Continuous-count mode: firmware derives the 1s/10s/100s errors from PPS timestamps of a
+        # free-running counter instead of the Tamer counters (that are reset on each sample).
+        if continuous:
+            self.pps_timestamp = _PPSTimestamp(pps=pps, config=config)
+            if self.irq.enabled:
+                self.irq.add("pps_timestamp", use_loc_if_exists=True)
+            self.comb += status_phase_error.eq(self.pps_timestamp.phase_error)
+        else:
+            self.comb += status_phase_error.eq(0)
+
+        # VCTCXO Tamer IRQ -------------------------------------------------------------------------
+
+        # Let the firmware sleep (wfi) between PPS events instead of polling the Tamer. The enable
+        # and PPS active change events wake the CPU on enable/disable and PPS loss even when no PPS
+        # is received, the long window event when the Tamer does not report an out of tolerance.
+        if self.irq.enabled:
+            self.vctcxo_tamer_irq = _VCTCXOTamerIRQ(
+                irq        = self.vctcxo_tamer.irq,
+                enable     = enable,
+                pps_active = pps_active,
+                long_done  = long_done,
+            )
+            self.irq.add("vctcxo_tamer_irq", use_loc_if_exists=True)
+
     def export_sources(self, filename):
         gateware_dir = os.path.join("build", self.platform.name, "gateware")
         output_path  = os.path.join(gateware_dir, filename)
@@ -223,8 +1201,71 @@ def main():
     parser.add_argument("--build",       action="store_true",  help="Generate Verilog.")
     parser.add_argument("--sys-clk-freq",default=6e6,          help="System clock frequency (default: 6MHz)")
     parser.add_argument("--dac-bits",    default=16,           help="DAC resolution in bits (default: 16")
+    parser.add_argument("--with-history",  action="store_true",  help="Add the per-PPS error history drained by the host.")
+    parser.add_argument("--history-depth", default=64, type=int, help="Error history depth in samples, power of 2 (default: 64).")
+    parser.add_argument("--outlier-window", default=0,  type=int, help="Outlier filter window in 1s samples, 3/5/7/9 or 0 to disable, best with --continuous (default: 0).")
+    parser.add_argument("--outlier-floor",  default=64, type=int, help="Outlier filter minimum rejection threshold in error counts (default: 64).")
+    parser.add_argument("--with-cycle-counter", action="store_true", help="Add a cycle counter for exact firmware delays (implied by --with-profiler).")
+    parser.add_argument("--with-profiler",  action="store_true",  help="Add the cycle counter/profiler and firmware timing reports.")
+    parser.add_argument("--with-long-window", action="store_true", help="Add the configurable-length (config_long_len) long averaging window.")
+    parser.add_argument("--with-holdover",  action="store_true",  help="Steer the trim DAC from a learned drift model while PPS is lost (default: hold).")
+    parser.add_argument("--with-snapshot",  action="store_true",  help="Add the Tamer errors snapshot latched on IRQ (counters kept running).")
+    parser.add_argument("--with-calibration", action="store_true", help="Add the calibration slope export and warm start (skips the coarse tune).")
+    parser.add_argument("--telemetry",      action="store_true",  help="Send a binary telemetry frame on the UART for each PPS measurement.")
+    parser.add_argument("--dac-slew",       default="none", choices=["none", "step", "exp"], help="Trim DAC slew: none, fixed step or exponential (default: none).")
+    parser.add_argument("--dac-slew-step",  default=256, type=int, help="Fixed slew step in DAC counts per tick (default: 256).")
+    parser.add_argument("--dac-slew-shift", default=2,   type=int, help="Exponential slew: 2^-N of the remaining step per tick (default: 2).")
+    parser.add_argument("--dac-slew-tick-ms", default=10, type=int, help="Slew tick period in ms (default: 10).")
+    parser.add_argument("--dac-settle-ms",  default=100, type=int, help="Settle interval after a slew before measuring, in ms (default: 100).")
+    parser.add_argument("--dac-frac-bits",  default=0,   type=int, help="Trim DAC fractional bits, sigma-delta dithered on the DAC output, 0-8 (default: 0).")
+    parser.add_argument("--dac-dither-freq", default=1e3, type=float, help="DAC dither update rate in Hz (default: 1kHz).")
+    parser.add_argument("--size-opt",       action="store_true",  help="Size-optimized firmware build (-Os, LTO, gc-sections, no stdio).")
+    parser.add_argument("--rom-size",       default=0x2000, type=lambda x: int(x, 0), help="Firmware ROM size in bytes, power of 2 (default: 0x2000).")
+    parser.add_argument("--sram-size",      default=0x100,  type=lambda x: int(x, 0), help="Firmware SRAM (data and stack) size in bytes, power of 2 (default: 0x100).")
+    parser.add_argument("--temp-comp",      action="store_true",  help="Learned temperature compensation (feed-forward) of the trim DAC.")
+    parser.add_argument("--temp-comp-min",  default=-40, type=int, help="Temperature compensation first node in C (default: -40).")
+    parser.add_argument("--temp-comp-step", default=8,   type=int, help="Temperature compensation node spacing in C, power of 2 (default: 8).")
+    parser.add_argument("--continuous",  action="store_true",  help="Zero dead-time measurements from free-running PPS timestamps.")
+    parser.add_argument("--lock-quality", action="store_true", help="Lock quality statistics and lock decision on the status outputs (needs --continuous).")
+    parser.add_argument("--pps-inputs",  default=1, type=int, choices=[1, 2, 3, 4], help="Number of PPS inputs, voted/switched by the firmware (needs --continuous for >1, default: 1).")
+    parser.add_argument("--ref-10mhz",   action="store_true", help="10 MHz reference input, measured instead of PPS when config_ref_enable is set.")
+    parser.add_argument("--ref-rate",    default=10, type=int, choices=[1, 2, 5, 10, 20, 50, 100], help="10 MHz reference ticks per second (measurement interval 1/N s, default: 10).")
+    parser.add_argument("--config-update", action="store_true", help="Runtime target/tolerance updates (config_gen handshake, applied at the next PPS) without a relock.")
+    parser.add_argument("--lock-quality-shift", default=6, type=int, help="Lock quality statistics window as 2^N samples (default: 6).")
+    parser.add_argument("--fixed-point", action="store_true",  help="Use integer-only (Q16.16) firmware tuning math.")
+    parser.add_argument("--coarse-tune", default="minmax", choices=["minmax", "search"], help="COARSE_TUNE strategy, search needs --continuous (default: minmax).")
+    parser.add_argument("--fine-tune",   default="proportional", choices=["proportional", "pi", "phase", "adaptive"], help="FINE_TUNE engine, pi/phase/adaptive need --continuous (default: proportional).")
+    parser.add_argument("--pi-kp-shift", default=2,  type=int, help="PI loop frequency gain as 2^-N (default: 2).")
+    parser.add_argument("--pi-ki-shift", default=6,  type=int, help="PI loop phase gain as 2^-N (default: 6).")
+    parser.add_argument("--adaptive-max-level", default=5, type=int, help="Adaptive FINE_TUNE longest window as 4^N s (default: 5, 1024s).")
     args = parser.parse_args()
 
+    # ROM/SRAM are mapped as power of 2 bus regions.
+    for name, size in [("--rom-size", args.rom_size), ("--sram-size", args.sram_size)]:
+        if (size <= 0) or (size & (size - 1)):
+            parser.error(f"{name} must be a power of 2.")
+
+    # The profiler report is printed with printf (stdio).
+    if args.size_opt and args.with_profiler:
+        parser.error("--size-opt is not compatible with --with-profiler.")
+
+    # The lock quality statistics need a measurement on every PPS.
+    if args.lock_quality and not args.continuous:
+        parser.error("--lock-quality requires --continuous.")
+
+    # The coarse search ends on an error within the tolerance (never reported by the Tamer).
+    if (args.coarse_tune == "search") and not args.continuous:
+        parser.error("--coarse-tune=search requires --continuous.")
+
+    # The PI/phase/adaptive loops run on every 1s sample (the Tamer only reports out of tolerance
+    # errors).
+    if (args.fine_tune in ["pi", "phase", "adaptive"]) and not args.continuous:
+        parser.error(f"--fine-tune={args.fine_tune} requires --continuous.")
+
+    # The PPS source voting compares the sources from their PPS timestamps.
+    if (args.pps_inputs > 1) and not args.continuous:
+        parser.error("--pps-inputs > 1 requires --continuous.")
+
     # SoC.
     for run in range(2):
         prepare = (run == 0)
@@ -232,15 +1273,54 @@ def main():
         soc = PPSDO(
             sys_clk_freq  = int(float(args.sys_clk_freq)),
             dac_bits      = int(args.dac_bits),
+            fixed_point   = args.fixed_point,
+            coarse_tune   = args.coarse_tune,
+            fine_tune     = args.fine_tune,
+            pi_kp_shift   = args.pi_kp_shift,
+            pi_ki_shift   = args.pi_ki_shift,
+            adaptive_max_level = args.adaptive_max_level,
+            history_depth = args.history_depth,
+            continuous    = args.continuous,
+            lock_quality  = args.lock_quality,
+            lock_quality_shift = args.lock_quality_shift,
+            pps_inputs    = args.pps_inputs,
+            ref_10mhz     = args.ref_10mhz,
+            ref_rate      = args.ref_rate,
+            config_update = args.config_update,
+            outlier_window = args.outlier_window,
+            outlier_floor  = args.outlier_floor,
+            temp_comp      = args.temp_comp,
+            temp_comp_min  = args.temp_comp_min,
+            temp_comp_step = args.temp_comp_step,
+            with_profiler  = args.with_profiler,
+            with_cycle_counter = args.with_cycle_counter,
+            with_calibration = args.with_calibration,
+            with_history  = args.with_history,
+            with_snapshot = args.with_snapshot,
+            with_long_window = args.with_long_window,
+            with_holdover  = args.with_holdover,
+            dac_slew       = args.dac_slew,
+            dac_slew_step  = args.dac_slew_step,
+            dac_slew_shift = args.dac_slew_shift,
+            dac_slew_tick_ms = args.dac_slew_tick_ms,
+            dac_settle_ms  = args.dac_settle_ms,
+            dac_frac_bits  = args.dac_frac_bits,
+            dac_dither_freq = args.dac_dither_freq,
+            telemetry      = args.telemetry,
+            rom_size       = args.rom_size,
+            sram_size      = args.sram_size,
             firmware_path = None if prepare else "firmware/firmware.bin",
         )
         soc.platform.name = "ppsdo"
         builder = Builder(soc)
         builder.build(run=build)
         if prepare:
-            ret = os.system(f"cd firmware && make clean all")
+            # Build the firmware and check it against the SoC ROM/SRAM sizes.
+            make_args  = f"ROM_BUDGET={args.rom_size:#x} SRAM_BUDGET={args.sram_size:#x}"
+            make_args += " SIZE_OPT=1" if args.size_opt else ""
+            ret = os.system(f"cd firmware && make clean all size {make_args}")
             if ret != 0:
-                raise RuntimeError("Firmware build failed.")
+                raise RuntimeError("Firmware build failed (or exceeds --rom-size/--sram-size, see the size report).")
 
     # Export sources
     soc.export_sources(f"ppsdo_sources.py")
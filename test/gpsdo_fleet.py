@@ -0,0 +1,113 @@
+#!/usr/bin/env python3
+#
+# This file is part of LimePSB_RPCM_GW.
+#
+# Copyright (c) 2024-2025 Lime Microsystems.
+#
+# SPDX-License-Identifier: Apache-2.0
+#
+# Fleet monitoring for several LimePSB-RPCM board GPSDOs from one host process: all boards are
+# sampled concurrently at each tick and reported as one merged, timestamped stream.
+#
+
+import sys
+import time
+import argparse
+from concurrent.futures import ThreadPoolExecutor
+
+from test_gpsdo import GPSDODriver
+
+# Fleet --------------------------------------------------------------------------------------------
+
+class GPSDOFleet:
+    """
+    Set of GPSDODrivers (one per SPI bus/device) sampled concurrently.
+
+    Each board has its own spidev handle; snapshots are taken from a thread pool (spidev transfers
+    release the GIL) so a tick costs about one board transfer time whatever the number of boards.
+    """
+    def __init__(self, devices, speed=500000, long_window=False):
+        self.names   = []
+        self.drivers = []
+        for bus, device in devices:
+            self.names.append(f"{bus}.{device}")
+            self.drivers.append(GPSDODriver(spi_bus=bus, spi_device=device, speed=speed, long_window=long_window))
+        self.pool = ThreadPoolExecutor(max_workers=len(self.drivers))
+
+    def get_snapshots(self):
+        """Get a snapshot of all boards: list of (name, snapshot or exception)."""
+        futures = [self.pool.submit(driver.get_snapshot) for driver in self.drivers]
+        results = []
+        for name, future in zip(self.names, futures):
+            try:
+                results.append((name, future.result()))
+            except OSError as e:
+                results.append((name, e))
+        return results
+
+    def close(self):
+        self.pool.shutdown()
+        for driver in self.drivers:
+            driver.close()
+
+# Test Functions -----------------------------------------------------------------------------------
+
+def parse_device(s):
+    """Parse a bus.device SPI device specification."""
+    bus, device = s.split(".")
+    return int(bus), int(device)
+
+def run_fleet_monitoring(fleet, num_ticks=0, period=1.0, output=sys.stdout):
+    # Header banner
+    header = "Time                    | Board | Enabled | 1s Error | 10s Error | 100s Error | Long Error | DAC Value | State        | Accuracy          | TPulse"
+
+    print(f"Monitoring {len(fleet.drivers)} GPSDOs (press Ctrl+C to stop):", file=sys.stderr)
+    print(header, file=output)
+
+    tick = 0
+    next_tick = (int(time.time() / period) + 1) * period
+    try:
+        while num_ticks == 0 or tick < num_ticks:
+            # Sleep until the next tick (aligned to the period, no busy-wait).
+            time.sleep(max(0.0, next_tick - time.time()))
+            stamp = time.strftime("%Y-%m-%dT%H:%M:%S", time.gmtime(next_tick)) + f".{int((next_tick % 1) * 1000):03d}Z"
+            next_tick += period
+
+            for name, snapshot in fleet.get_snapshots():
+                if isinstance(snapshot, Exception):
+                    print(f"{stamp} | {name:5} | error: {snapshot}", file=output)
+                    continue
+                status = snapshot["status"]
+                print(f"{stamp} | {name:5} | {str(snapshot['enabled']):7} | {snapshot['error_1s']:8d} | {snapshot['error_10s']:9d} | {snapshot['error_100s']:10d} | {snapshot['error_long']:10d} | 0x{snapshot['dac']:04X}    | {status['state']:12} | {status['accuracy']:17} | {str(status['tpulse_active']):6}", file=output)
+            output.flush()
+
+            # Skip ticks missed (slow transfers).
+            if next_tick < time.time():
+                next_tick = (int(time.time() / period) + 1) * period
+            tick += 1
+    except KeyboardInterrupt:
+        print("\nMonitoring stopped.", file=sys.stderr)
+
+# Main ----------------------------------------------------------------------------------------------
+
+def main():
+    parser = argparse.ArgumentParser(description="GPSDO Fleet Monitoring")
+    parser.add_argument("--device",  default=[(1, 1)], nargs="+", type=parse_device, help="SPI devices as bus.device (default: 1.1)")
+    parser.add_argument("--num",     default=0,     type=int,   help="Number of ticks (0 for infinite)")
+    parser.add_argument("--period",  default=1.0,   type=float, help="Sampling period (seconds)")
+    parser.add_argument("--speed",   default=500000, type=int,  help="SPI clock frequency (Hz)")
+    parser.add_argument("--output",  default=None,              help="Merged stream output file (default: stdout)")
+    parser.add_argument("--long-window", action="store_true",   help="Read the long window error (gpsdocfg with the long window)")
+    args = parser.parse_args()
+
+    fleet  = GPSDOFleet(args.device, speed=args.speed, long_window=args.long_window)
+    output = sys.stdout if args.output is None else open(args.output, "a")
+    try:
+        run_fleet_monitoring(fleet, num_ticks=args.num, period=args.period, output=output)
+    finally:
+        fleet.close()
+        if output is not sys.stdout:
+            output.close()
+
+if __name__ == "__main__":
+    main()
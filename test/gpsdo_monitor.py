@@ -0,0 +1,383 @@
+#!/usr/bin/env python3
+#
+# This file is part of LimePSB_RPCM_GW.
+#
+# Copyright (c) 2024-2025 Lime Microsystems.
+#
+# SPDX-License-Identifier: Apache-2.0
+#
+# Long-running monitoring daemon for LimePSB-RPCM board GPSDO: PPS aligned sampling, rotating binary
+# logs and incremental overlapping Allan deviation / time-to-lock. Logs can be exported as traces for
+# the firmware host simulation (src/firmware/sim, replayed with --replay).
+#
+
+import os
+import time
+import math
+import signal
+import struct
+import argparse
+from collections import deque
+
+from test_gpsdo import (GPSDODriver, get_field, read_temp_sensor, REG_PPS_1S_TARGET_L,
+    REG_PPS_1S_TARGET_H, STATUS_STATE_OFFSET, STATUS_STATE_SIZE, STATUS_ACCURACY_OFFSET,
+    STATUS_ACCURACY_SIZE, TEMP_NOT_AVAILABLE)
+
+# Constants ----------------------------------------------------------------------------------------
+
+# Log file format: header (magic, 1s target) followed by fixed-size little-endian records.
+LOG_MAGIC              = b"PPSDOLG2"
+LOG_HEADER_FORMAT      = "<8sII"      # magic, 1s target (counts), reserved.
+LOG_RECORD_FORMAT      = "<dIiiiiHHH" # time, seq, 1s/10s/100s/long errors, DAC value, status, temperature.
+LOG_HEADER_SIZE        = struct.calcsize(LOG_HEADER_FORMAT)
+LOG_RECORD_SIZE        = struct.calcsize(LOG_RECORD_FORMAT)
+
+# Version 1 logs (no temperature), still read.
+LOG_MAGIC_V1           = b"PPSDOLG1"
+LOG_RECORD_FORMAT_V1   = "<dIiiiiHH"
+LOG_RECORD_SIZE_V1     = struct.calcsize(LOG_RECORD_FORMAT_V1)
+
+# Status flags stored in the unused status register bits of the log records.
+LOG_STATUS_REPEAT      = (1 << 15) # No register change seen at this PPS epoch: previous values.
+
+# PPS alignment.
+PPS_PERIOD             = 1.0  # Seconds.
+PPS_GUARD              = 0.1  # Fast polling window around the expected PPS epoch (seconds).
+
+# Trace export: trim DAC mid-scale, the free-running frequency reference point of the traces.
+TRACE_DAC_MID          = 0x8000
+
+# Lock: FINE_TUNE with the highest accuracy.
+LOCK_STATE             = 1
+LOCK_ACCURACY          = 3
+
+# AllanDeviation -----------------------------------------------------------------------------------
+
+class AllanDeviation:
+    """
+    Streaming overlapping Allan deviation of the 1s error at octave averaging times.
+
+    The error samples are integrated to phase (in counts, exact integers) and only the last
+    2 * max_tau + 1 phase values are kept, so memory is bounded whatever the run length. Gaps reset
+    the phase history; accumulated sums are kept (segments are concatenated).
+    """
+    def __init__(self, target, max_tau=4096):
+        self.target = target
+        self.taus   = [1 << i for i in range(int(math.log2(max_tau)) + 1)]
+        self.sums   = {tau: 0 for tau in self.taus}
+        self.counts = {tau: 0 for tau in self.taus}
+        self.reset()
+
+    def reset(self):
+        """Start a new segment (gap in the data)."""
+        self.phase   = 0
+        self.history = deque([0], maxlen=2*self.taus[-1] + 1)
+
+    def add(self, error):
+        """Add a 1s error sample (counts)."""
+        self.phase += error
+        self.history.append(self.phase)
+        n = len(self.history)
+        for tau in self.taus:
+            if n < 2*tau + 1:
+                break
+            d = self.history[-1] - 2*self.history[-1 - tau] + self.history[-1 - 2*tau]
+            self.sums[tau]   += d*d
+            self.counts[tau] += 1
+
+    def adev(self, tau):
+        """Overlapping Allan deviation (fractional frequency) at tau seconds, None if no data."""
+        if self.counts[tau] == 0:
+            return None
+        return math.sqrt(self.sums[tau] / (2 * tau*tau * self.counts[tau])) / self.target
+
+    def results(self):
+        return [(tau, self.adev(tau), self.counts[tau]) for tau in self.taus if self.counts[tau]]
+
+# LockTracker --------------------------------------------------------------------------------------
+
+class LockTracker:
+    """
+    Time-to-lock tracker: time from enable (or lock loss) to FINE_TUNE at the highest accuracy.
+    """
+    def __init__(self):
+        self.locked = False
+        self.start  = None
+        self.last   = None # Last time-to-lock (seconds).
+        self.count  = 0
+        self.total  = 0.0
+
+    def update(self, t, enabled, status_raw):
+        state    = get_field(status_raw, STATUS_STATE_OFFSET,    STATUS_STATE_SIZE)
+        accuracy = get_field(status_raw, STATUS_ACCURACY_OFFSET, STATUS_ACCURACY_SIZE)
+        locked   = enabled and (state == LOCK_STATE) and (accuracy == LOCK_ACCURACY)
+        if not enabled:
+            self.start = None
+        elif not locked and self.start is None:
+            self.start = t
+        elif locked and self.start is not None:
+            self.last   = t - self.start
+            self.count += 1
+            self.total += self.last
+            self.start  = None
+        self.locked = locked
+        return locked
+
+# SampleLog ----------------------------------------------------------------------------------------
+
+class SampleLog:
+    """
+    Rotating binary sample log (one file per rotate interval, named from its start time).
+    """
+    def __init__(self, log_dir, target, rotate=24*3600):
+        self.log_dir = log_dir
+        self.target  = target
+        self.rotate  = rotate
+        self.file    = None
+        self.opened  = 0
+        os.makedirs(log_dir, exist_ok=True)
+
+    def write(self, t, seq, snapshot, status_raw, temp=None):
+        if self.file is None or (t - self.opened) >= self.rotate:
+            self.open(t)
+        temp_raw = TEMP_NOT_AVAILABLE if temp is None else max(-0x7FFF, min(0x7FFF, round(temp * 16))) & 0xFFFF
+        self.file.write(struct.pack(LOG_RECORD_FORMAT, t, seq,
+            snapshot["error_1s"], snapshot["error_10s"], snapshot["error_100s"], snapshot["error_long"],
+            snapshot["dac"], status_raw, temp_raw))
+        self.file.flush()
+
+    def open(self, t):
+        self.close()
+        name = time.strftime("ppsdo_%Y%m%d_%H%M%S.bin", time.gmtime(t))
+        self.file   = open(os.path.join(self.log_dir, name), "wb")
+        self.opened = t
+        self.file.write(struct.pack(LOG_HEADER_FORMAT, LOG_MAGIC, self.target, 0))
+
+    def close(self):
+        if self.file is not None:
+            self.file.close()
+            self.file = None
+
+def read_log(path):
+    """Read a sample log: returns the 1s target and yields (time, seq, errors..., dac, status, temp).
+
+    temp is in C, None when not recorded.
+    """
+    with open(path, "rb") as f:
+        magic, target, _ = struct.unpack(LOG_HEADER_FORMAT, f.read(LOG_HEADER_SIZE))
+        if magic not in [LOG_MAGIC, LOG_MAGIC_V1]:
+            raise ValueError(f"{path}: not a PPSDO sample log.")
+        record_format = LOG_RECORD_FORMAT    if magic == LOG_MAGIC else LOG_RECORD_FORMAT_V1
+        record_size   = LOG_RECORD_SIZE      if magic == LOG_MAGIC else LOG_RECORD_SIZE_V1
+        yield target
+        while True:
+            record = f.read(record_size)
+            if len(record) < record_size:
+                break
+            values = struct.unpack(record_format, record)
+            if magic == LOG_MAGIC_V1 or values[-1] == TEMP_NOT_AVAILABLE:
+                yield values[:8] + (None,)
+            else:
+                yield values[:8] + ((values[-1] - 0x10000 if values[-1] & 0x8000 else values[-1]) / 16,)
+
+# Daemon Functions ---------------------------------------------------------------------------------
+
+def sample_key(snapshot):
+    return (snapshot["error_1s"], snapshot["error_10s"], snapshot["error_100s"], snapshot["dac"],
+            snapshot["status_raw"])
+
+def wait_for_pps(driver, last_key, expected, poll=0.01):
+    """Wait for the next PPS epoch, seen as a change of the per-PPS registers.
+
+    Sleeps until just before the expected epoch, then polls fast. Returns (time, snapshot, repeat):
+    repeat is set when no change was seen by the end of the window (identical values at this epoch).
+    """
+    now = time.time()
+    if expected is not None and expected - PPS_GUARD > now:
+        time.sleep(expected - PPS_GUARD - now)
+    while True:
+        snapshot = driver.get_snapshot()
+        now      = time.time()
+        if sample_key(snapshot) != last_key:
+            return now, snapshot, False
+        if expected is not None and now > expected + PPS_GUARD:
+            return expected, snapshot, True
+        time.sleep(poll)
+
+def print_summary(elapsed, samples, adev, lock):
+    last = f"{lock.last:.1f}s" if lock.last is not None else "-"
+    mean = f"{lock.total / lock.count:.1f}s" if lock.count else "-"
+    print(f"--- {samples} samples, {elapsed/3600:.2f}h, locked: {lock.locked}, "
+          f"time-to-lock: last {last}, mean {mean} ({lock.count} locks)")
+    for tau, value, count in adev.results():
+        print(f"    ADEV tau={tau:5d}s: {value:.3e} ({count} samples)")
+
+def run_daemon(driver, log_dir="logs", rotate=24*3600, summary=60, max_tau=4096, temp_sensor=None):
+    target = (driver.read_register(REG_PPS_1S_TARGET_H) << 16) | driver.read_register(REG_PPS_1S_TARGET_L)
+    if target == 0:
+        raise RuntimeError("1s target not configured (enable the GPSDO first).")
+
+    log     = SampleLog(log_dir, target, rotate)
+    adev    = AllanDeviation(target, max_tau)
+    lock    = LockTracker()
+    running = [True]
+
+    def stop(signum, frame):
+        running[0] = False
+    signal.signal(signal.SIGTERM, stop)
+
+    print(f"Monitoring GPSDO ({target} counts/s) to {log_dir}, press Ctrl+C to stop.")
+    t_start  = time.time()
+    t_report = t_start
+    samples  = 0
+    expected = None
+    last_key = None
+    try:
+        while running[0]:
+            # Log the board temperature (and forward it for compensation).
+            temp = None
+            if temp_sensor is not None:
+                temp = read_temp_sensor(temp_sensor)
+                if driver.temp_comp:
+                    driver.set_temperature(temp)
+
+            t, snapshot, repeat = wait_for_pps(driver, last_key, expected)
+            status_raw = snapshot["status_raw"]
+            pps_active = snapshot["status"]["tpulse_active"]
+
+            # Repeated values are only trusted while PPS is present; otherwise: gap.
+            if repeat and not pps_active:
+                adev.reset()
+                expected = None
+                continue
+
+            log.write(t, samples, snapshot, status_raw | (LOG_STATUS_REPEAT if repeat else 0), temp)
+            if lock.update(t, snapshot["enabled"], status_raw):
+                adev.add(snapshot["error_1s"])
+            else:
+                adev.reset()
+
+            samples += 1
+            last_key = sample_key(snapshot)
+            expected = t + PPS_PERIOD
+
+            if t - t_report >= summary:
+                t_report = t
+                print_summary(time.time() - t_start, samples, adev, lock)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        log.close()
+    print_summary(time.time() - t_start, samples, adev, lock)
+
+def analyze_logs(paths, max_tau=4096):
+    """Recompute ADEV/time-to-lock from sample logs (in time order)."""
+    adev  = None
+    lock  = LockTracker()
+    t0    = None
+    t1    = None
+    count = 0
+    for path in paths:
+        records = read_log(path)
+        target  = next(records)
+        adev    = adev or AllanDeviation(target, max_tau)
+        for t, seq, error_1s, error_10s, error_100s, error_long, dac, status_raw, temp in records:
+            t0 = t if t0 is None else t0
+            # Missing PPS epochs: gap.
+            if t1 is not None and (t - t1) > 1.5*PPS_PERIOD:
+                adev.reset()
+            t1 = t
+            if lock.update(t, True, status_raw):
+                adev.add(error_1s)
+            else:
+                adev.reset()
+            count += 1
+    if adev is not None:
+        print_summary((t1 - t0) if t0 is not None else 0, count, adev, lock)
+
+def export_trace(paths, output, slope=None):
+    """Export sample logs (in time order) as a host simulation replay trace.
+
+    The recorded 1s errors are converted to the free-running VCTCXO frequency error at mid-scale DAC
+    (removing the trim DAC contribution, with the tuning slope estimated from the 1s error changes at
+    the DAC steps when not given) and written one record per second, missing PPS epochs as PPS
+    absent. The PPS jitter is part of the recorded errors: PPS time errors are written as 0.
+    """
+    samples = []
+    target  = None
+    for path in paths:
+        records     = read_log(path)
+        file_target = next(records)
+        target      = target or file_target
+        for t, seq, error_1s, error_10s, error_100s, error_long, dac, status_raw, temp in records:
+            samples.append((t, error_1s / target * 1e9, dac, temp))
+    if target is None or not samples:
+        raise ValueError("No samples to export.")
+
+    # Trim DAC applied during each 1s measurement: the one set at the previous PPS.
+    applied = [samples[0][2]] + [s[2] for s in samples[:-1]]
+
+    # Tuning slope: least squares of the 1s error changes over the DAC changes (consecutive epochs).
+    if slope is None:
+        num = den = 0.0
+        for i in range(1, len(samples)):
+            d = applied[i] - applied[i - 1]
+            if d != 0 and (samples[i][0] - samples[i - 1][0]) < 1.5*PPS_PERIOD:
+                num += (samples[i][1] - samples[i - 1][1]) * d
+                den += d * d
+        if den == 0:
+            raise ValueError("No trim DAC change in the logs: give the tuning slope.")
+        slope = num / den
+
+    def format_temp(temp):
+        return "" if temp is None else f"{temp:.2f}"
+
+    with open(output, "w") as f:
+        print(f"# PPSDO replay trace: {len(samples)} samples, f0 {target} Hz, slope {slope:.6f} ppb/count.", file=f)
+        print("t,pps,ppb,pps_ns,temp_c", file=f)
+        t0   = samples[0][0]
+        last = None # (second, free-running frequency error, temperature) of the last record.
+        for (t, ppb, dac, temp), dac_applied in zip(samples, applied):
+            n = round((t - t0) / PPS_PERIOD)
+            if last is not None and n <= last[0]:
+                continue
+            # Missing PPS epochs: PPS absent, frequency error held.
+            for m in range(last[0] + 1, n) if last is not None else []:
+                print(f"{m},0,{last[1]:.3f},,{format_temp(last[2])}", file=f)
+            last = (n, ppb - slope * (dac_applied - TRACE_DAC_MID), temp)
+            print(f"{n},1,{last[1]:.3f},0,{format_temp(temp)}", file=f)
+    print(f"Exported {len(samples)} samples to {output} (f0 {target} Hz, slope {slope:.6f} ppb/count).")
+
+# Main ----------------------------------------------------------------------------------------------
+
+def main():
+    parser = argparse.ArgumentParser(description="GPSDO Monitoring Daemon")
+    parser.add_argument("--log-dir",     default="logs",              help="Sample log directory")
+    parser.add_argument("--rotate",      default=24.0,  type=float,   help="Log rotation interval (hours)")
+    parser.add_argument("--summary",     default=60.0,  type=float,   help="ADEV/time-to-lock summary interval (seconds)")
+    parser.add_argument("--max-tau",     default=4096,  type=int,     help="Longest ADEV averaging time (seconds, power of 2)")
+    parser.add_argument("--temp-sensor", default=None,                help="Temperature sysfs file (millidegrees C) logged (and forwarded with --temp-comp)")
+    parser.add_argument("--temp-comp",   action="store_true",         help="Forward the temperature to the GPSDO (--temp-comp gateware)")
+    parser.add_argument("--long-window", action="store_true",         help="Read the long window error (gpsdocfg with the long window)")
+    parser.add_argument("--analyze",     default=None,  nargs="+",    help="Analyze sample logs instead of monitoring")
+    parser.add_argument("--export",      default=None,                help="Export the analyzed sample logs as a simulation replay trace (CSV)")
+    parser.add_argument("--slope",       default=None,  type=float,   help="VCTCXO tuning slope for the export (ppb/DAC count, default: estimated)")
+    args = parser.parse_args()
+
+    # Analyze.
+    if args.analyze:
+        analyze_logs(args.analyze, max_tau=args.max_tau)
+        if args.export:
+            export_trace(args.analyze, args.export, slope=args.slope)
+        return
+
+    # Monitor.
+    driver = GPSDODriver(long_window=args.long_window, temp_comp=args.temp_comp)
+    try:
+        run_daemon(driver, log_dir=args.log_dir, rotate=args.rotate*3600, summary=args.summary,
+            max_tau=args.max_tau, temp_sensor=args.temp_sensor)
+    finally:
+        driver.close()
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,167 @@
+#!/usr/bin/env python3
+#
+# This file is part of LimePSB_RPCM_GW.
+#
+# Copyright (c) 2024-2025 Lime Microsystems.
+#
+# SPDX-License-Identifier: Apache-2.0
+#
+# Telemetry decoder for the PPSDO firmware UART binary frames (PPSDO built with --telemetry).
+#
+
+import struct
+import argparse
+
+# Constants ----------------------------------------------------------------------------------------
+
+# Frame format (see src/firmware/telemetry.h), little-endian.
+TLM_SYNC               = b"\xA5\x5A"
+TLM_FRAME_SIZE         = 29
+TLM_PAYLOAD_FORMAT     = "<BBBHiiiii" # seq, state, flags, dac, 1s/10s/100s/long/phase errors.
+
+# Flags.
+TLM_FLAG_ERR_1S        = (1 << 0)
+TLM_FLAG_ERR_10S       = (1 << 1)
+TLM_FLAG_ERR_100S      = (1 << 2)
+TLM_FLAG_ERR_LONG      = (1 << 3)
+TLM_FLAG_PPS_ACTIVE    = (1 << 4)
+
+# Firmware tuning states (state_t).
+TLM_STATES = {
+    0: "Coarse Min",
+    1: "Coarse Max",
+    2: "Coarse Done",
+    3: "Coarse Search",
+    4: "Fine Tune",
+    5: "Holdover",
+    6: "Idle",
+}
+
+# Helper function to compute the frame CRC (CRC-16/CCITT-FALSE).
+def crc16(data, crc=0xFFFF):
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if (crc & 0x8000) else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+# TelemetryDecoder ---------------------------------------------------------------------------------
+
+class TelemetryDecoder:
+    """
+    Stream decoder for PPSDO telemetry frames.
+
+    Bytes are fed as they are received; frames are located from their sync word and validated with
+    their CRC, so the decoder resynchronizes on its own after garbage or text output on the UART.
+    """
+    def __init__(self):
+        self.buf        = bytearray()
+        self.last_seq   = None
+        self.crc_errors = 0
+        self.lost       = 0
+
+    def feed(self, data):
+        """Feed received bytes, return the list of decoded frames."""
+        frames = []
+        self.buf += data
+        while True:
+            start = self.buf.find(TLM_SYNC)
+            if start < 0:
+                # Keep a possible partial sync word.
+                del self.buf[:max(0, len(self.buf) - 1)]
+                break
+            del self.buf[:start]
+            if len(self.buf) < TLM_FRAME_SIZE:
+                break
+            frame = bytes(self.buf[:TLM_FRAME_SIZE])
+            if crc16(frame[2:-2]) != struct.unpack("<H", frame[-2:])[0]:
+                # Not a frame (or corrupted): resync after this sync word.
+                self.crc_errors += 1
+                del self.buf[:1]
+                continue
+            del self.buf[:TLM_FRAME_SIZE]
+            frames.append(self.decode_frame(frame))
+        return frames
+
+    def decode_frame(self, frame):
+        """Decode a validated frame."""
+        seq, state, flags, dac, error_1s, error_10s, error_100s, error_long, phase = struct.unpack(
+            TLM_PAYLOAD_FORMAT, frame[2:-2])
+
+        # Frames dropped by the firmware (or lost on the link) show as sequence gaps.
+        lost = 0 if self.last_seq is None else (seq - self.last_seq - 1) & 0xFF
+        self.last_seq = seq
+        self.lost     += lost
+
+        return {
+            "seq"        : seq,
+            "lost"       : lost,
+            "state"      : TLM_STATES.get(state, f"Unknown ({state})"),
+            "pps_active" : bool(flags & TLM_FLAG_PPS_ACTIVE),
+            "flags"      : flags,
+            "dac"        : dac,
+            "error_1s"   : error_1s,
+            "error_10s"  : error_10s,
+            "error_100s" : error_100s,
+            "error_long" : error_long,
+            "phase"      : phase,
+        }
+
+# Test Functions -----------------------------------------------------------------------------------
+
+def format_flags(flags):
+    names = [("1s", TLM_FLAG_ERR_1S), ("10s", TLM_FLAG_ERR_10S), ("100s", TLM_FLAG_ERR_100S), ("long", TLM_FLAG_ERR_LONG)]
+    return ",".join(name for name, bit in names if flags & bit) or "-"
+
+def run_decoder(stream, num_frames=0, banner_interval=10):
+    # Header banner
+    header = "  Seq | Lost | State         | PPS   | 1s Error | 10s Error | 100s Error | Long Error |    Phase | DAC Value | Out of Tol."
+
+    print("Decoding PPSDO telemetry (press Ctrl+C to stop):")
+    print(header)
+
+    decoder     = TelemetryDecoder()
+    frame_count = 0
+    try:
+        while num_frames == 0 or frame_count < num_frames:
+            data = stream.read(TLM_FRAME_SIZE)
+            if not data:
+                if not hasattr(stream, "in_waiting"):
+                    break # End of file.
+                continue
+            for f in decoder.feed(data):
+                # Single-line output
+                print(f"{f['seq']:5d} | {f['lost']:4d} | {f['state']:13} | {str(f['pps_active']):5} | {f['error_1s']:8d} | {f['error_10s']:9d} | {f['error_100s']:10d} | {f['error_long']:10d} | {f['phase']:8d} | 0x{f['dac']:04X}    | {format_flags(f['flags'])}")
+
+                frame_count += 1
+
+                # Print banner every banner_interval frames
+                if frame_count % banner_interval == 0:
+                    print(header)
+    except KeyboardInterrupt:
+        print("\nDecoding stopped.")
+
+    print(f"{frame_count} frames, {decoder.lost} lost, {decoder.crc_errors} CRC errors.")
+
+# Main ----------------------------------------------------------------------------------------------
+
+def main():
+    parser = argparse.ArgumentParser(description="PPSDO Telemetry Decoder")
+    parser.add_argument("--port",     default="/dev/ttyS0",      help="Serial port connected to the PPSDO UART")
+    parser.add_argument("--baudrate", default=115200, type=int, help="Serial port baudrate")
+    parser.add_argument("--file",     default=None,              help="Decode a raw capture file instead of the serial port")
+    parser.add_argument("--num",      default=0,      type=int, help="Number of frames to decode (0 for infinite)")
+    parser.add_argument("--banner",   default=10,     type=int, help="Banner repeat interval")
+    args = parser.parse_args()
+
+    if args.file is not None:
+        with open(args.file, "rb") as stream:
+            run_decoder(stream, num_frames=args.num, banner_interval=args.banner)
+    else:
+        import serial
+        with serial.Serial(args.port, args.baudrate, timeout=1.0) as stream:
+            run_decoder(stream, num_frames=args.num, banner_interval=args.banner)
+
+if __name__ == "__main__":
+    main()
@@ -16,6 +16,13 @@ import math
 
 # Constants ----------------------------------------------------------------------------------------
 
+# SPI commands.
+SPI_CMD_READ           = 0x00
+SPI_CMD_WRITE          = 0x80
+
+# Register reads retried for a consistent value (registers updated at each PPS, seconds apart).
+READ_STABLE_RETRIES    = 4
+
 # Register addresses.
 REG_CONTROL            = 0x0000
 REG_PPS_1S_TARGET_L    = 0x0001
@@ -35,6 +42,26 @@ REG_PPS_100S_ERR_L     = 0x000E
 REG_PPS_100S_ERR_H     = 0x000F
 REG_DAC_TUNED_VAL      = 0x0010
 REG_STATUS             = 0x0011
+REG_PPS_LONG_LEN       = 0x0012
+REG_PPS_LONG_TARGET_L  = 0x0013
+REG_PPS_LONG_TARGET_H  = 0x0014
+REG_PPS_LONG_ERR_TOL   = 0x0015
+REG_PPS_LONG_ERR_L     = 0x0016
+REG_PPS_LONG_ERR_H     = 0x0017
+REG_TEMP               = 0x0018 # Signed, 1/16 C (0x8000: not available).
+REG_CONFIG_GEN         = 0x0019 # Targets/tolerances generation (change: applied at the next PPS).
+REG_HISTORY_SEQ_L      = 0x001A # History sequence counter (samples pushed).
+REG_HISTORY_SEQ_H      = 0x001B
+REG_HISTORY_ADDR       = 0x001C # History read address (sample index % depth).
+REG_HISTORY_DATA_0     = 0x001D # 1s error [15:0].
+REG_HISTORY_DATA_1     = 0x001E # 1s error [31:16].
+REG_HISTORY_DATA_2     = 0x001F # DAC value.
+REG_HISTORY_DATA_3     = 0x0020 # State [3:0], flags [7:4], sequence [15:8] (read: next address).
+
+TEMP_NOT_AVAILABLE     = 0x8000
+
+# History sample flags (windows out of tolerance).
+HISTORY_FLAGS          = {0x1: "1s", 0x2: "10s", 0x4: "100s", 0x8: "long"}
 
 # Status bit fields
 STATUS_STATE_OFFSET    = 0
@@ -67,34 +94,88 @@ class GPSDODriver:
     Driver for LimePSB-RPCM GPSDO gpsdocfg registers.
 
     This driver handles SPI communication to read/write registers and decode values.
+
+    The long window registers (REG_PPS_LONG_*, gpsdocfg with the long window) are only accessed with
+    long_window enabled, the error history registers (REG_HISTORY_*, gateware built with
+    --with-history) with history enabled, the temperature register (REG_TEMP, gateware built with
+    --temp-comp) with temp_comp enabled and the configuration generation register (REG_CONFIG_GEN,
+    gateware built with --config-update) with config_update enabled.
+
+    Registers are read one by one: multi-register values (32-bit L/H pairs, snapshots) are re-read
+    until stable so that all their registers come from the same PPS epoch.
     """
-    def __init__(self, spi_bus=1, spi_device=1, speed=500000, mode=0):
+    def __init__(self, spi_bus=1, spi_device=1, speed=500000, mode=0, long_window=False, history=False, temp_comp=False,
+        config_update=False):
         self.spi              = spidev.SpiDev()
         self.spi.open(spi_bus, spi_device)
         self.spi.max_speed_hz = speed
         self.spi.mode         = mode
+        self.long_window      = long_window
+        self.history          = history
+        self.temp_comp        = temp_comp
+        self.config_update    = config_update
 
     def read_register(self, address):
         """Read a 16-bit register value."""
-        tx_data = [0x00, (address & 0xFF), 0x00, 0x00]
+        tx_data = [SPI_CMD_READ, (address & 0xFF), 0x00, 0x00]
         rx_data = self.spi.xfer2(tx_data)
         value   = (rx_data[2] << 8) | rx_data[3]
         return value
 
     def write_register(self, address, value):
         """Write a 16-bit value to a register."""
-        tx_data = [0x80, (address & 0xFF), (value >> 8) & 0xFF, value & 0xFF]
+        tx_data = [SPI_CMD_WRITE, (address & 0xFF), (value >> 8) & 0xFF, value & 0xFF]
         self.spi.xfer2(tx_data)
 
-    def get_signed_32bit(self, low_addr, high_addr):
-        """Get signed 32-bit value from low/high registers."""
-        low   = self.read_register(low_addr)
-        high  = self.read_register(high_addr)
+    def read_block(self, address, count):
+        """Read count consecutive 16-bit registers starting at address (one read per register)."""
+        return [self.read_register(address + i) for i in range(count)]
+
+    def read_block_stable(self, address, count):
+        """Read count consecutive 16-bit registers, all from the same PPS epoch.
+
+        The block is re-read until two consecutive reads match: a register update during the first
+        read changes a value already read, one during the second read a value of the first read, and
+        updates are one PPS apart (a few ms of SPI reads). The last read is returned after
+        READ_STABLE_RETRIES mismatches.
+        """
+        regs = self.read_block(address, count)
+        for _ in range(READ_STABLE_RETRIES):
+            again = self.read_block(address, count)
+            if again == regs:
+                break
+            regs = again
+        return regs
+
+    def read_32bit(self, low_addr, high_addr):
+        """Read an unsigned 32-bit value from low/high registers, both from the same PPS epoch.
+
+        The high register is read before and after the low one (H/L/H) and the read retried while it
+        changes: with an unchanged high register, the low register completes it consistently whether
+        it was read before or after an update.
+        """
+        high = self.read_register(high_addr)
+        for _ in range(READ_STABLE_RETRIES):
+            low       = self.read_register(low_addr)
+            high_next = self.read_register(high_addr)
+            if high_next == high:
+                break
+            high = high_next
+        return (high << 16) | low
+
+    @staticmethod
+    def to_signed_32bit(low, high):
+        """Combine low/high 16-bit values into a signed 32-bit value."""
         value = (high << 16) | low
         if value & (1 << 31):  # Sign extend if negative
             value -= (1 << 32)
         return value
 
+    def get_signed_32bit(self, low_addr, high_addr):
+        """Get signed 32-bit value from low/high registers."""
+        value = self.read_32bit(low_addr, high_addr)
+        return self.to_signed_32bit(value & 0xFFFF, value >> 16)
+
     def get_1s_error(self):
         """Get 1s error as signed 32-bit."""
         return self.get_signed_32bit(REG_PPS_1S_ERR_L, REG_PPS_1S_ERR_H)
@@ -107,17 +188,25 @@ class GPSDODriver:
         """Get 100s error as signed 32-bit."""
         return self.get_signed_32bit(REG_PPS_100S_ERR_L, REG_PPS_100S_ERR_H)
 
+    def get_long_error(self):
+        """Get long window error as signed 32-bit."""
+        return self.get_signed_32bit(REG_PPS_LONG_ERR_L, REG_PPS_LONG_ERR_H)
+
     def get_dac_value(self):
         """Get DAC tuned value."""
         return self.read_register(REG_DAC_TUNED_VAL)
 
     def get_status(self):
         """Get decoded status: state, accuracy, tpulse_active."""
-        status    = self.read_register(REG_STATUS)
+        return self.decode_status(self.read_register(REG_STATUS))
+
+    @staticmethod
+    def decode_status(status):
+        """Decode status register value: state, accuracy, tpulse_active."""
         state     = get_field(status, STATUS_STATE_OFFSET, STATUS_STATE_SIZE)
         accuracy  = get_field(status, STATUS_ACCURACY_OFFSET, STATUS_ACCURACY_SIZE)
         tpulse    = get_field(status, STATUS_TPULSE_OFFSET, STATUS_TPULSE_SIZE)
-        state_str = "Coarse Tune" if state == 0 else "Fine Tune" if state == 1 else f"Unknown ({state})"
+        state_str = {0: "Coarse Tune", 1: "Fine Tune", 2: "Holdover"}.get(state, f"Unknown ({state})")
         accuracy_str = ['Disabled/Lowest', '1s Tune', '2s Tune', '3s Tune (Highest)'][accuracy] if accuracy < 4 else f"Unknown ({accuracy})"
         return {
             "state": state_str,
@@ -125,6 +214,59 @@ class GPSDODriver:
             "tpulse_active": bool(tpulse)
         }
 
+    def get_snapshot(self):
+        """Get enabled, errors, DAC value and decoded status, all from the same PPS epoch.
+
+        The long window error is read in the same block with long_window enabled (0 otherwise).
+        """
+        last = REG_PPS_LONG_ERR_H if self.long_window else REG_STATUS
+        regs = self.read_block_stable(REG_CONTROL, last - REG_CONTROL + 1)
+        reg  = lambda addr: regs[addr - REG_CONTROL]
+        return {
+            "enabled"    : bool(reg(REG_CONTROL) & 0x0001),
+            "error_1s"   : self.to_signed_32bit(reg(REG_PPS_1S_ERR_L),   reg(REG_PPS_1S_ERR_H)),
+            "error_10s"  : self.to_signed_32bit(reg(REG_PPS_10S_ERR_L),  reg(REG_PPS_10S_ERR_H)),
+            "error_100s" : self.to_signed_32bit(reg(REG_PPS_100S_ERR_L), reg(REG_PPS_100S_ERR_H)),
+            "error_long" : self.to_signed_32bit(reg(REG_PPS_LONG_ERR_L), reg(REG_PPS_LONG_ERR_H)) if self.long_window else 0,
+            "dac"        : reg(REG_DAC_TUNED_VAL),
+            "status"     : self.decode_status(reg(REG_STATUS)),
+            "status_raw" : reg(REG_STATUS),
+        }
+
+    def set_temperature(self, celsius):
+        """Set the board temperature used for compensation (None: not available)."""
+        if celsius is None:
+            value = TEMP_NOT_AVAILABLE
+        else:
+            value = max(-0x7FFF, min(0x7FFF, round(celsius * 16))) & 0xFFFF
+        self.write_register(REG_TEMP, value)
+
+    def get_history(self, start_seq=None, depth=64):
+        """Drain the history samples pushed since start_seq (None: all the samples held).
+
+        Each sample is one 4-register read, the read address moving to the next sample on the
+        REG_HISTORY_DATA_3 read (so not re-read: the sample sequence tag is checked instead).
+        Samples overwritten before being read (more than depth behind) are dropped. Returns
+        (samples, next_seq), to give next_seq back as start_seq on the next call.
+        """
+        seq   = self.read_32bit(REG_HISTORY_SEQ_L, REG_HISTORY_SEQ_H)
+        start = seq - depth if start_seq is None else start_seq
+        start = max(start, seq - depth, 0)
+        self.write_register(REG_HISTORY_ADDR, start % depth)
+        samples = []
+        for n in range(start, seq):
+            data = self.read_block(REG_HISTORY_DATA_0, 4)
+            if (data[3] >> 8) != (n & 0xFF):
+                continue
+            samples.append({
+                "seq"      : n,
+                "error_1s" : self.to_signed_32bit(data[0], data[1]),
+                "dac"      : data[2],
+                "state"    : get_field(data[3], 0, 4),
+                "flags"    : [name for bit, name in HISTORY_FLAGS.items() if get_field(data[3], 4, 4) & bit],
+            })
+        return samples, seq
+
     def get_enabled(self):
         """Get enabled status from control register."""
         control = self.read_register(REG_CONTROL)
@@ -142,9 +284,17 @@ class GPSDODriver:
 
 # Test Functions -----------------------------------------------------------------------------------
 
-def run_monitoring(driver, num_dumps=0, delay=1.0, banner_interval=10):
+def read_temp_sensor(path):
+    """Read a temperature in C from a hwmon/thermal sysfs file (millidegrees), None on error."""
+    try:
+        with open(path, "r") as f:
+            return int(f.read().strip()) / 1000
+    except (OSError, ValueError):
+        return None
+
+def run_monitoring(driver, num_dumps=0, delay=1.0, banner_interval=10, temp_sensor=None):
     # Header banner
-    header = "Dump | Enabled | 1s Error | 10s Error | 100s Error | DAC Value | State        | Accuracy          | TPulse"
+    header = "Dump | Enabled | 1s Error | 10s Error | 100s Error | Long Error | DAC Value | State        | Accuracy          | TPulse"
 
     print("Monitoring GPSDO regulation loop (press Ctrl+C to stop):")
     print(header)
@@ -152,15 +302,21 @@ def run_monitoring(driver, num_dumps=0, delay=1.0, banner_interval=10):
     dump_count = 0
     try:
         while num_dumps == 0 or dump_count < num_dumps:
-            enabled   = driver.get_enabled()
-            error_1s  = driver.get_1s_error()
-            error_10s = driver.get_10s_error()
-            error_100s = driver.get_100s_error()
-            dac       = driver.get_dac_value()
-            status    = driver.get_status()
+            # Forward the board temperature for compensation.
+            if temp_sensor is not None and driver.temp_comp:
+                driver.set_temperature(read_temp_sensor(temp_sensor))
+
+            snapshot   = driver.get_snapshot()
+            enabled    = snapshot["enabled"]
+            error_1s   = snapshot["error_1s"]
+            error_10s  = snapshot["error_10s"]
+            error_100s = snapshot["error_100s"]
+            error_long = snapshot["error_long"]
+            dac        = snapshot["dac"]
+            status     = snapshot["status"]
 
             # Single-line output
-            print(f"{dump_count + 1:4d} | {str(enabled):7} | {error_1s:8d} | {error_10s:9d} | {error_100s:10d} | 0x{dac:04X}    | {status['state']:12} | {status['accuracy']:17} | {str(status['tpulse_active']):6}")
+            print(f"{dump_count + 1:4d} | {str(enabled):7} | {error_1s:8d} | {error_10s:9d} | {error_100s:10d} | {error_long:10d} | 0x{dac:04X}    | {status['state']:12} | {status['accuracy']:17} | {str(status['tpulse_active']):6}")
 
             dump_count += 1
 
@@ -201,14 +357,54 @@ def dump_registers(driver, num_dumps=1, delay=1.0):
             REG_PPS_100S_ERR_L,
             REG_PPS_100S_ERR_H,
             REG_DAC_TUNED_VAL,
-            REG_STATUS
+            REG_STATUS,
         ]
+        if driver.long_window:
+            regs += [
+                REG_PPS_LONG_LEN,
+                REG_PPS_LONG_TARGET_L,
+                REG_PPS_LONG_TARGET_H,
+                REG_PPS_LONG_ERR_TOL,
+                REG_PPS_LONG_ERR_L,
+                REG_PPS_LONG_ERR_H,
+            ]
+        if driver.temp_comp:
+            regs += [
+                REG_TEMP,
+            ]
+        if driver.config_update:
+            regs += [
+                REG_CONFIG_GEN,
+            ]
+        if driver.history:
+            regs += [
+                REG_HISTORY_SEQ_L,
+                REG_HISTORY_SEQ_H,
+            ]
 
         for addr in regs:
             value    = driver.read_register(addr)
             reg_name = reg_names.get(addr, "UNKNOWN")
             print(f"0x{addr:04X} ({reg_name:{max_name_len}}): 0x{value:04X}")
 
+def run_history(driver, num_reads=0, delay=1.0, depth=64):
+    # Drain the history periodically (gateware built with --with-history), samples are printed once.
+    print("Draining GPSDO error history (press Ctrl+C to stop):")
+    print("Sequence   | 1s Error | DAC Value | State | Out of Tolerance")
+
+    seq   = None
+    reads = 0
+    try:
+        while num_reads == 0 or reads < num_reads:
+            samples, seq = driver.get_history(start_seq=seq, depth=depth)
+            for sample in samples:
+                print(f"{sample['seq']:10d} | {sample['error_1s']:8d} | 0x{sample['dac']:04X}    | {sample['state']:5d} | {','.join(sample['flags'])}")
+            reads += 1
+            if num_reads == 0 or reads < num_reads:
+                time.sleep(delay)
+    except KeyboardInterrupt:
+        print("\nHistory drain stopped.")
+
 def reset_gpsdo(driver, reset_delay=2.0):
     print("Resetting GPSDO...")
     driver.set_enabled(False)
@@ -216,19 +412,26 @@ def reset_gpsdo(driver, reset_delay=2.0):
     driver.set_enabled(True)
     print("GPSDO reset complete (re-enabled).")
 
-def enable_gpsdo(driver, clk_freq_mhz=30.72, ppm=0.1):
+def configure_gpsdo(driver, clk_freq_mhz=30.72, ppm=0.1, long_len=0, long_ppb=1.0):
     freq = clk_freq_mhz * 1e6
 
     # Compute targets (expected counter values for intervals).
     target_1s   = int(freq)
     target_10s  = int(10 * freq)
     target_100s = int(100 * freq)
+    target_long = int(long_len * freq) & 0xFFFFFFFF # Modulo 2^32 (counter wraps).
 
     # Compute tolerances in Hz for constant ppm across intervals.
     tol_1s_hz   = round(freq * ppm / 1e6)
     tol_10s_hz  = tol_1s_hz * 10
     tol_100s_hz = tol_1s_hz * 100
 
+    # Long window tolerance from its own (tighter) fractional target: the point of the long window
+    # is a resolution beyond the 100s one (e.g. 1ppb over 1000s at 30.72MHz: 31 counts).
+    tol_long_hz = max(1, round(freq * long_len * long_ppb / 1e9))
+    if driver.long_window and (tol_long_hz > 0xFFFF):
+        raise ValueError(f"Long window tolerance of {tol_long_hz} counts does not fit REG_PPS_LONG_ERR_TOL (16-bit): reduce --long-ppb or --long-len.")
+
     # Configure 1s Target and Tolerance.
     driver.write_register(REG_PPS_1S_TARGET_L, target_1s & 0xFFFF)
     driver.write_register(REG_PPS_1S_TARGET_H, target_1s >> 16)
@@ -244,16 +447,45 @@ def enable_gpsdo(driver, clk_freq_mhz=30.72, ppm=0.1):
     driver.write_register(REG_PPS_100S_TARGET_H, target_100s >> 16)
     driver.write_register(REG_PPS_100S_ERR_TOL, tol_100s_hz)
 
+    # Configure Long window Length, Target and Tolerance (0: disabled), when present.
+    if driver.long_window:
+        driver.write_register(REG_PPS_LONG_LEN, long_len)
+        driver.write_register(REG_PPS_LONG_TARGET_L, target_long & 0xFFFF)
+        driver.write_register(REG_PPS_LONG_TARGET_H, target_long >> 16)
+        driver.write_register(REG_PPS_LONG_ERR_TOL, tol_long_hz)
+
     # Set CLK_SEL (0: 30.72MHz LMKRF, 1: 10MHz LMK10).
     clk_sel = 1 if math.isclose(clk_freq_mhz, 10.0) else 0
 
+    long_str = f", {long_len}s={tol_long_hz}Hz ({long_ppb}ppb)" if driver.long_window else ""
+    return clk_sel, f"CLK_SEL={clk_sel} ({clk_freq_mhz}MHz), {ppm}ppm tolerance " \
+        f"(1s tol={tol_1s_hz}Hz, 10s={tol_10s_hz}Hz, 100s={tol_100s_hz}Hz{long_str})"
+
+def enable_gpsdo(driver, clk_freq_mhz=30.72, ppm=0.1, long_len=0, long_ppb=1.0):
+    clk_sel, config = configure_gpsdo(driver, clk_freq_mhz=clk_freq_mhz, ppm=ppm, long_len=long_len, long_ppb=long_ppb)
+
     # Enable (EN=1).
     control = set_field(0, CONTROL_CLK_SEL_OFFSET, CONTROL_CLK_SEL_SIZE, clk_sel)
     control = set_field(control, CONTROL_EN_OFFSET, CONTROL_EN_SIZE, 1)
     driver.write_register(REG_CONTROL, control)
 
-    print(f"GPSDO enabled: CLK_SEL={clk_sel} ({clk_freq_mhz}MHz), {ppm}ppm tolerance "
-          f"(1s tol={tol_1s_hz}Hz, 10s={tol_10s_hz}Hz, 100s={tol_100s_hz}Hz).")
+    print(f"GPSDO enabled: {config}.")
+
+def update_gpsdo(driver, clk_freq_mhz=30.72, ppm=0.1, long_len=0, long_ppb=1.0):
+    # Runtime update (gateware built with --config-update): the new targets/tolerances are applied
+    # together at the next PPS once the generation changes, the loop keeps its lock (no re-enable).
+    clk_sel, config = configure_gpsdo(driver, clk_freq_mhz=clk_freq_mhz, ppm=ppm, long_len=long_len, long_ppb=long_ppb)
+
+    # Set CLK_SEL, preserving EN.
+    control = driver.read_register(REG_CONTROL)
+    control = set_field(control, CONTROL_CLK_SEL_OFFSET, CONTROL_CLK_SEL_SIZE, clk_sel)
+    driver.write_register(REG_CONTROL, control)
+
+    # Apply (next generation).
+    gen = (driver.read_register(REG_CONFIG_GEN) + 1) & 0xFF
+    driver.write_register(REG_CONFIG_GEN, gen)
+
+    print(f"GPSDO updated (generation {gen}): {config}.")
 
 def disable_gpsdo(driver):
     # Disable.
@@ -269,15 +501,26 @@ def main():
     parser.add_argument("--reset",       action="store_true",       help="Reset GPSDO")
     parser.add_argument("--enable",      action="store_true",       help="Configure and enable GPSDO")
     parser.add_argument("--disable",     action="store_true",       help="Disable GPSDO")
+    parser.add_argument("--history",     action="store_true",       help="Drain the error history (--with-history gateware, --num/--delay as for --check)")
+    parser.add_argument("--history-depth", default=64,  type=int,   help="Error history depth in samples, as built (for --history)")
+    parser.add_argument("--history-regs", action="store_true",      help="Access the error history registers (--with-history gateware, implied by --history)")
+    parser.add_argument("--update",      action="store_true",       help="Update targets/tolerances at runtime, without re-enable (--config-update gateware)")
+    parser.add_argument("--config-update", action="store_true",     help="Access the configuration generation register (--config-update gateware, implied by --update)")
     parser.add_argument("--num",         default=0,     type=int,   help="Number of iterations (for --check: 0 for infinite; for --dump: default 1 if not specified)")
     parser.add_argument("--delay",       default=1.0,   type=float, help="Delay between iterations (seconds, for --check and --dump)")
     parser.add_argument("--banner",      default=10,    type=int,   help="Banner repeat interval (for --check)")
     parser.add_argument("--reset-delay", default=2.0,   type=float, help="Delay after disable before re-enable (seconds, for --reset)")
     parser.add_argument("--clk-freq",    default=30.72, type=float, help="Clock frequency in MHz (10 or 30.72)")
     parser.add_argument("--ppm",         default=0.1,   type=float, help="Tolerance in ppm")
+    parser.add_argument("--long-len",    default=0,     type=int,   help="Long averaging window length in seconds (0 to disable, implies --long-window otherwise)")
+    parser.add_argument("--long-ppb",    default=1.0,   type=float, help="Long window tolerance in ppb (tighter than --ppm for the longer window resolution)")
+    parser.add_argument("--long-window", action="store_true",       help="Access the long window registers (gpsdocfg with the long window)")
+    parser.add_argument("--temp-comp",   action="store_true",       help="Access the temperature register (--temp-comp gateware)")
+    parser.add_argument("--temp-sensor", default=None,              help="Temperature sysfs file (millidegrees C) forwarded to the GPSDO (for --check, with --temp-comp)")
     args = parser.parse_args()
 
-    driver = GPSDODriver()
+    driver = GPSDODriver(long_window=args.long_window or (args.long_len > 0), history=args.history_regs or args.history,
+        temp_comp=args.temp_comp, config_update=args.config_update or args.update)
     try:
 
         # Dump.
@@ -287,7 +530,11 @@ def main():
 
         # Enable.
         if args.enable:
-            enable_gpsdo(driver, clk_freq_mhz=args.clk_freq, ppm=args.ppm)
+            enable_gpsdo(driver, clk_freq_mhz=args.clk_freq, ppm=args.ppm, long_len=args.long_len, long_ppb=args.long_ppb)
+
+        # Update.
+        if args.update:
+            update_gpsdo(driver, clk_freq_mhz=args.clk_freq, ppm=args.ppm, long_len=args.long_len, long_ppb=args.long_ppb)
 
         # Disable.
         if args.disable:
@@ -297,9 +544,13 @@ def main():
         if args.reset:
             reset_gpsdo(driver, reset_delay=args.reset_delay)
 
+        # History.
+        if args.history:
+            run_history(driver, num_reads=args.num, delay=args.delay, depth=args.history_depth)
+
         # Check.
         if args.check:
-            run_monitoring(driver, num_dumps=args.num, delay=args.delay, banner_interval=args.banner)
+            run_monitoring(driver, num_dumps=args.num, delay=args.delay, banner_interval=args.banner, temp_sensor=args.temp_sensor)
     finally:
         driver.close()
 